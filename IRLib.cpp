@@ -33,6 +33,58 @@
 #include <Arduino.h>
 
 volatile irparams_t irparams;
+
+//The buffer behind a decoder's rawbuf
+#ifdef IRLIB_VIEW_CAPTURE
+#define RAWBUF_OF(decoder) ((decoder)->rawbuf.buf)
+#else
+#define RAWBUF_OF(decoder) ((decoder)->rawbuf)
+#endif
+
+/*
+ * IRdecodeHash compares each interval with the one two before it. The new one is shorter if
+ * it is less than 0.8 of the old one and longer if the old one is less than 0.8 of it.
+ * The result is folded into an FNV hash. See IRdecodeHash::decode.
+ */
+#define FNV_PRIME_32 16777619
+#define FNV_BASIS_32 2166136261
+static inline unsigned char Hash_Compare(unsigned int oldval, unsigned int newval) {
+  if (5UL*newval < 4UL*oldval) return 0;
+  if (5UL*oldval < 4UL*newval) return 2;
+  return 1;
+}
+
+#ifdef IRLIB_ROLLING_HASH
+//Entry i of the frame being recorded as GetResults will convert it
+static inline unsigned int Hash_Time(volatile irparams_t &Rcv, irindex_t i) {
+  unsigned int Excess=Rcv.hashexcess;
+  return (unsigned int)Rcv.rawbuf[i]*Rcv.hashtick + ((i % 2)? -Excess: Excess);
+}
+#endif
+
+//Appends an interval in the receiver's units to the frame being recorded
+static inline void Record(volatile irparams_t &Rcv, unsigned long Value) {
+#ifdef IRLIB_COMPACT_CAPTURE
+  if (Rcv.rawlen == 0)
+    Rcv.slotgap[Rcv.head % IRLIB_CAPTURE_SLOTS] = (Value>0xffff)? 0xffff: Value;
+  if (Value>IRLIB_SAMPLE_ESCAPE) Value=IRLIB_SAMPLE_ESCAPE;
+#endif
+  Rcv.rawbuf[Rcv.rawlen++] = Value;
+#ifdef IRLIB_ROLLING_HASH
+  irindex_t Len=Rcv.rawlen;
+  if (Len == 1) Rcv.hash=FNV_BASIS_32;
+  else if (Len > 3)
+    Rcv.hash=(Rcv.hash*FNV_PRIME_32) ^ Hash_Compare(Hash_Time(Rcv,Len-3),Hash_Time(Rcv,Len-1));
+#endif
+}
+
+//Entry i of a slot in the receiver's units
+static inline unsigned int Sample(volatile irparams_t &Rcv, unsigned char Slot, irindex_t i) {
+#ifdef IRLIB_COMPACT_CAPTURE
+  if (i == 0) return Rcv.slotgap[Slot];
+#endif
+  return Rcv.slots[Slot][i];
+}
 /*
  * Returns a pointer to a flash stored string that is the name of the protocol received. 
  */
@@ -46,6 +98,17 @@ const __FlashStringHelper *Pnames(IRTYPES Type) {
 
 #define TOPBIT 0x80000000
 
+/*
+ * Descriptions of the protocols which use the generic send and decode routines.
+ * Head_Mark, Head_Space, Mark_One, Mark_Zero, Space_One, Space_Zero, Max_Extent, kHz, Num_Bits, Use_Stop
+ */
+const IRprotocol IRprotocol_NEC PROGMEM=          {564*16, 564*8, 564, 564, 564*3, 564, 0, 38, 32, true};
+const IRprotocol IRprotocol_Sony PROGMEM=         {600*4, 600, 600*2, 600, 600, 600, 45000, 40, 0, false};
+const IRprotocol IRprotocol_Sony8 PROGMEM=        {600*4, 600, 600*2, 600, 600, 600, 22000, 40, 0, false};
+const IRprotocol IRprotocol_Panasonic_Old PROGMEM={833*4, 833*4, 833, 833, 833*3, 833, 0, 57, 22, true};
+const IRprotocol IRprotocol_JVC PROGMEM=          {525*16, 525*8, 525, 525, 525*3, 525, 0, 38, 16, true};
+const IRprotocol IRprotocol_NECx PROGMEM=         {564*8, 564*8, 564, 564, 564*3, 564, 108000, 38, 32, true};
+
 /*
  * The IRsend classes contain a series of methods for sending various protocols.
  * Each of these begin by calling enableIROut(unsigned char kHz) to set the carrier frequency.
@@ -96,6 +159,13 @@ void IRsendBase::sendGeneric(unsigned long data, unsigned char Num_Bits, unsigne
 	else space(Space_One);
 };
 
+void IRsendBase::sendGeneric(const IRprotocol *Protocol, unsigned long data, unsigned char Num_Bits, bool Header) {
+  IRprotocol P; memcpy_P(&P, Protocol, sizeof(P));
+  if(!Header) P.Head_Mark=P.Head_Space=0;
+  sendGeneric(data, Num_Bits? Num_Bits: P.Num_Bits, P.Head_Mark, P.Head_Space, P.Mark_One, P.Mark_Zero, 
+              P.Space_One, P.Space_Zero, P.kHz, P.Use_Stop, P.Max_Extent);
+};
+
 void IRsendNEC::send(unsigned long data)
 {
   if (data==REPEAT) {
@@ -103,7 +173,7 @@ void IRsendNEC::send(unsigned long data)
     mark (564* 16); space(564*4); mark(564);space(56*173);
   }
   else {
-    sendGeneric(data,32, 564*16, 564*8, 564, 564, 564*3, 564, 38, true);
+    sendGeneric(&IRprotocol_NEC, data);
   }
 };
 
@@ -114,7 +184,7 @@ void IRsendNEC::send(unsigned long data)
  */
 void IRsendSony::send(unsigned long data, int nbits) {
   for(int i=0; i<3;i++){
-     sendGeneric(data,nbits, 600*4, 600, 600*2, 600, 600, 600, 40, false,((nbits==8)? 22000:45000)); 
+     sendGeneric((nbits==8)? &IRprotocol_Sony8: &IRprotocol_Sony, data, nbits); 
   }
 };
 
@@ -123,16 +193,16 @@ void IRsendSony::send(unsigned long data, int nbits) {
  */
 void IRsendNECx::send(unsigned long data)
 {
-  sendGeneric(data,32, 564*8, 564*8, 564, 564, 564*3, 564, 38, true, 108000);
+  sendGeneric(&IRprotocol_NECx, data);
 };
 
 void IRsendPanasonic_Old::send(unsigned long data)
 {
-  sendGeneric(data,22, 833*4, 833*4, 833, 833, 833*3, 833,57, true);
+  sendGeneric(&IRprotocol_Panasonic_Old, data);
 };
 
 /*
- * JVC omits the mark/space header on repeat sending. Therefore we multiply it by 0 if it's a repeat.
+ * JVC omits the mark/space header on repeat sending. Therefore we leave it out if it's a repeat.
  * The only device I had to test this protocol was an old JVC VCR. It would only work if at least
  * 2 frames are sent separated by 45us of "space". Therefore you should call this routine once with
  * "First=true" and it will send a first frame followed by one repeat frame. If First== false,
@@ -140,18 +210,18 @@ void IRsendPanasonic_Old::send(unsigned long data)
  */
 void IRsendJVC::send(unsigned long data, bool First)
 {
-  sendGeneric(data, 16,525*16*First, 525*8*First, 525, 525,525*3, 525, 38, true);
+  sendGeneric(&IRprotocol_JVC, data, 0, First);
   space(525*45);
-  if(First) sendGeneric(data, 16,0,0, 525, 525,525*3, 525, 38, true);
+  if(First) sendGeneric(&IRprotocol_JVC, data, 0, false);
 }
 
 /*
  * The remaining protocols require special treatment. They were in the original IRremote library.
  */
-void IRsendRaw::send(unsigned int buf[], unsigned char len, unsigned char hz)
+void IRsendRaw::send(unsigned int buf[], irindex_t len, unsigned char hz)
 {
   enableIROut(hz);
-  for (unsigned char i = 0; i < len; i++) {
+  for (irindex_t i = 0; i < len; i++) {
     if (i & 1) {
       space(buf[i]);
     } 
@@ -162,6 +232,158 @@ void IRsendRaw::send(unsigned int buf[], unsigned char len, unsigned char hz)
   space(0); // Just to be sure
 }
 
+/*
+ * Reads one number of a code made by IRsendRaw::pack. Intervals are only a byte or two
+ * each so reading one between a mark and a space adds a few microseconds at most.
+ */
+static unsigned long Get_Packed(const unsigned char *&Code) {
+  unsigned long Value=0; unsigned char Shift=0, Byte;
+  do {
+    Byte=pgm_read_byte(Code++);
+    Value|=(unsigned long)(Byte & 0x7f)<<Shift; Shift+=7;
+  } while (Byte & 0x80);
+  return Value;
+}
+
+void IRsendRaw::send_P(const unsigned char *Code)
+{
+  enableIROut(pgm_read_byte(Code++));
+  unsigned int len=Get_Packed(Code); //a code from IRpronto::pack may be longer than RAWBUF
+  unsigned int Last[2]={0,0};
+  for (unsigned int i = 0; i < len; i++) {
+    unsigned long Zigzag=Get_Packed(Code);
+    Last[i & 1]+=(Zigzag & 1)? ~(unsigned int)(Zigzag>>1): (unsigned int)(Zigzag>>1);
+    if (i & 1) {
+      space(Last[1]);
+    } 
+    else {
+      mark(Last[0]);
+    }
+  }
+  space(0);
+}
+
+static bool Put_Packed(unsigned char *Code, unsigned int &Used, unsigned int Max, unsigned long Value) {
+  do {
+    if (Used >= Max) return false;
+    Code[Used++]=(Value & 0x7f) | (Value>0x7f? 0x80: 0);
+    Value>>=7;
+  } while (Value);
+  return true;
+}
+
+unsigned int IRsendRaw::pack(const unsigned int *buf, irindex_t len, unsigned char khz,
+                             unsigned char *Code, unsigned int Max)
+{
+  unsigned int Used=0;
+  if (!Max) return 0;
+  Code[Used++]=khz;
+  if (!Put_Packed(Code,Used,Max,len)) return 0;
+  for (irindex_t i = 0; i < len; i++) {
+    long Diff=(long)buf[i]-(i>1? buf[i-2]: 0);
+    if (!Put_Packed(Code,Used,Max,Diff<0? ((unsigned long)~Diff<<1)|1: (unsigned long)Diff<<1)) return 0;
+  }
+  return Used;
+}
+
+bool IRsendRaw::sendPronto(const char *Pronto)
+{
+  IRpronto Code;
+  if (!Code.begin(Pronto)) return false;
+  enableIROut(Code.kHz);
+  unsigned int Time;
+  for (unsigned int i = 0; Code.next(Time); i++) {
+    if (i & 1) {
+      space(Time);
+    } 
+    else {
+      mark(Time);
+    }
+  }
+  space(0);
+  return true;
+}
+
+bool IRpronto::word(unsigned int &W) {
+  while (*P == ' ' || *P == '\t' || *P == '\r' || *P == '\n') P++;
+  W=0;
+  const char *Start=P;
+  for (;; P++) {
+    unsigned char Digit;
+    if (*P >= '0' && *P <= '9') Digit=*P-'0';
+    else if ((*P|0x20) >= 'a' && (*P|0x20) <= 'f') Digit=(*P|0x20)-'a'+10;
+    else break;
+    W=(W<<4)|Digit;
+  }
+  return P != Start && P-Start <= 4;
+}
+
+/*
+ * The carrier period is kept in 1/256us because 241246 times the code would overflow
+ * an unsigned long if it was scaled up any further before dividing. Codes for carriers
+ * below 4kHz or above 255kHz are refused so that the times can't overflow either.
+ */
+bool IRpronto::begin(const char *Pronto) {
+  unsigned int Type, Freq, Once, Repeat;
+  P=Pronto; Left=0; Len=0; kHz=0;
+  if (!word(Type) || Type || !word(Freq) || Freq < 17 || Freq > 1000 || !word(Once) || !word(Repeat)) return false;
+  if ((Once? Once: Repeat) > 0x7fff) return false; //twice as many intervals must fit Len
+  Cycle=(Freq*241246UL+1953)/3906;
+  kHz=(4145146UL/Freq+500)/1000;
+  Len=Left=2*(Once? Once: Repeat);
+  return true;
+}
+
+bool IRpronto::next(unsigned int &usec) {
+  unsigned int Cycles;
+  if (!Left || !word(Cycles)) return false;
+  Left--;
+  unsigned long Time=(Cycles*Cycle+128)>>8;
+  usec=(Time>0xffff)? 0xffff: Time;
+  return true;
+}
+
+unsigned int IRpronto::pack(unsigned char *Code, unsigned int Max) {
+  unsigned int Used=0, Time, Last[2]={0,0};
+  if (!Max) return 0;
+  Code[Used++]=kHz;
+  if (!Put_Packed(Code,Used,Max,Left)) return 0;
+  for (unsigned int i = 0; next(Time); i++) {
+    long Diff=(long)Time-Last[i & 1];
+    Last[i & 1]=Time;
+    if (!Put_Packed(Code,Used,Max,Diff<0? ((unsigned long)~Diff<<1)|1: (unsigned long)Diff<<1)) return 0;
+  }
+  return Left? 0: Used;
+}
+
+static char *Put_Word(char *Out, unsigned int W) {
+  for (int i = 12; i >= 0; i -= 4) *Out++ = "0123456789ABCDEF"[(W>>i) & 15];
+  *Out++=' ';
+  return Out;
+}
+
+/*
+ * Writes the intervals after the leading gap as a learned Pronto code with the given
+ * frequency, all of them sent once. A capture ends with a mark so a space of 5000us, the
+ * gap a receiver waits for before it reports a frame, completes the last pair. Returns
+ * the number of characters not counting the terminating null or 0 if they don't fit.
+ */
+unsigned int IRdecodeBase::toPronto(char *Buf, unsigned int Max, unsigned char khz) {
+  irindex_t Pairs=rawlen/2;        //rawlen-1 intervals rounded up to pairs
+  if (!khz || Max < 5*(4+2*(unsigned long)Pairs)) return 0;
+  unsigned int Freq=(4145146UL+khz*500UL)/(khz*1000UL);
+  unsigned long Cycle=(Freq*241246UL+1953)/3906;
+  char *Out=Buf;
+  Out=Put_Word(Out,0); Out=Put_Word(Out,Freq); Out=Put_Word(Out,Pairs); Out=Put_Word(Out,0);
+  for (irindex_t i = 1; i <= 2*Pairs; i++) {
+    unsigned long Time=(i < rawlen)? (unsigned long)rawbuf[i]: 5000;
+    unsigned long Cycles=((Time<<8)+Cycle/2)/Cycle;
+    Out=Put_Word(Out,(Cycles>0xffff)? 0xffff: Cycles);
+  }
+  *--Out=0;
+  return Out-Buf;
+}
+
 /*
  * The RC5 protocol uses a phase encoding of data bits. A space/mark pair indicates "1"
  * and a mark/space indicates a "0". It begins with a single "1" bit which is not encoded
@@ -245,6 +467,63 @@ void IRsend::send(IRTYPES Type, unsigned long data, unsigned int data2) {
   }
 }
 
+void IRsendBase::beginRecord(unsigned int *Buf, irindex_t Max) {
+  Rec_Buf=Buf; Rec_Max=Max;
+  Rec_Len=0; Rec_Over=false; Rec_kHz=0;
+  Recording=true;
+}
+
+bool IRsendBase::endRecord(void) {
+  Recording=false;
+  return !Rec_Over && Rec_Len;
+}
+
+/*
+ * While recording, consecutive marks or spaces are joined into one interval. Intervals too
+ * long for an unsigned int are cut short, which only happens to the gap after a frame.
+ */
+void IRsendBase::store(unsigned int time, bool Mark) {
+  Extent+=time;
+  if (Rec_Len == 0 && !Mark) return;  //nothing to space from
+  if (((Rec_Len & 1) == 0) == Mark) {
+    if (Rec_Len >= Rec_Max) {Rec_Over=true; return;}
+    Rec_Last=time; Rec_Len++;
+  } else {
+    unsigned long Sum=(unsigned long)Rec_Last+time;
+    Rec_Last= Sum>65535? 65535: Sum;
+  }
+  if (Rec_Buf) Rec_Buf[Rec_Len-1]=Rec_Last;
+}
+
+IRsendMulti::IRsendMulti(void) {
+  Count=0; Loaded_kHz=0;
+}
+
+bool IRsendMulti::addEmitter(unsigned char GatePin, unsigned int *Buf, irindex_t Size) {
+  if (Count == IRLIB_MAX_EMITTERS) return false;
+  pinMode(GatePin, OUTPUT);
+  digitalWrite(GatePin, LOW);
+  Emitters[Count].Pin=GatePin; Emitters[Count].Buf=Buf; Emitters[Count].Size=Size;
+  Emitters[Count++].Len=0;
+  return true;
+}
+
+void IRsendMulti::send(unsigned char Mask, IRTYPES Type, unsigned long data, unsigned int data2) {
+  for(unsigned char i=0; i<Count; i++) if (Mask & (1<<i)) digitalWrite(Emitters[i].Pin, HIGH);
+  IRsend::send(Type, data, data2);
+  for(unsigned char i=0; i<Count; i++) digitalWrite(Emitters[i].Pin, LOW);
+}
+
+bool IRsendMulti::load(unsigned char Emitter, IRTYPES Type, unsigned long data, unsigned int data2) {
+  if (Emitter >= Count || !Emitters[Emitter].Buf) return false;
+  beginRecord(Emitters[Emitter].Buf, Emitters[Emitter].Size);
+  IRsend::send(Type, data, data2);
+  Emitters[Emitter].Len= endRecord()? Rec_Len: 0;
+  if (!Emitters[Emitter].Len) return false;
+  if (!Loaded_kHz) Loaded_kHz=Rec_kHz;
+  return true;
+}
+
 /*
  * The irparams definitions which were located here have been moved to IRLibRData.h
  */
@@ -256,19 +535,32 @@ void IRsend::send(IRTYPES Type, unsigned long data, unsigned int data2) {
  * creation of alternative receiver classes separate from the decoder classes.
  */
 IRdecodeBase::IRdecodeBase(void) {
-  rawbuf=(volatile unsigned int*)irparams.rawbuf;
+#ifdef IRLIB_COMPACT_CAPTURE
+  rawbuf=irparams.view;
+#elif defined(IRLIB_VIEW_CAPTURE)
+  rawbuf.set(irparams.slots[0]);
+#else
+  rawbuf=irparams.slots[0];
+#endif
+  ExtnBuf=false;
   IgnoreHeader=false;
   Reset();
 };
 
 /*
- * Normally the decoder uses irparams.rawbuf but if you want to resume receiving while
+ * Normally the decoder uses the receiver's buffer but if you want to resume receiving while
  * still decoding you can define a separate buffer and pass the address here. 
+ * (With IRLIB_CAPTURE_SLOTS greater than 1 the receiver keeps recording anyway.)
  * Then IRrecvBase::GetResults will copy the raw values from its buffer to yours allowing you to
  * call IRrecvBase::resume immediately before you call decode.
  */
 void IRdecodeBase::UseExtnBuf(void *P){
+  ExtnBuf=true;
+#ifdef IRLIB_VIEW_CAPTURE
+  rawbuf.set((volatile unsigned int*)P);
+#else
   rawbuf=(volatile unsigned int*)P;
+#endif
 };
 
 /*
@@ -276,8 +568,21 @@ void IRdecodeBase::UseExtnBuf(void *P){
  * for usage.
  */
 void IRdecodeBase::copyBuf (IRdecodeBase *source){
-   memcpy((void *)rawbuf,(const void *)source->rawbuf,sizeof(irparams.rawbuf));
+//If we use the receiver's buffers, copying into one of them could overwrite a frame still being
+//recorded so simply look at the same data as the source.
+   if (!ExtnBuf)
+     rawbuf=source->rawbuf;
+#ifdef IRLIB_VIEW_CAPTURE
+   else
+     for(irindex_t i=0; i<source->rawlen; i++) rawbuf.buf[i]=source->rawbuf[i];
+#else
+   else
+     memcpy((void *)rawbuf,(const void *)source->rawbuf,RAWBUF*sizeof(unsigned int));
+#endif
    rawlen=source->rawlen;
+#ifdef IRLIB_ROLLING_HASH
+   HashReady=source->HashReady; rawhash=source->rawhash;
+#endif
 };
 
 /*
@@ -293,6 +598,9 @@ void IRdecodeBase::Reset(void) {
   value=0;
   bits=0;
   rawlen=0;
+#ifdef IRLIB_ROLLING_HASH
+  HashReady=false;
+#endif
 };
 #ifndef USE_DUMP
 void DumpUnavailable(void) {Serial.println(F("DumpResults unavailable"));}
@@ -350,11 +658,11 @@ void IRdecodeBase::DumpResults(void) {
  * we assume that the length of Mark varies and the value passed as "Space_Zero" is ignored.
  * When using variable length Mark, assumes Head_Space==Space_One. If it doesn't, you need a specialized decoder.
  */
-bool IRdecodeBase::decodeGeneric(unsigned char Raw_Count, unsigned int Head_Mark, unsigned int Head_Space, 
+bool IRdecodeBase::decodeGeneric(irindex_t Raw_Count, unsigned int Head_Mark, unsigned int Head_Space, 
                                  unsigned int Mark_One, unsigned int Mark_Zero, unsigned int Space_One, unsigned int Space_Zero) {
 // If raw samples count or head mark are zero then don't perform these tests.
 // Some protocols need to do custom header work.
-  unsigned long data = 0;  unsigned char Max; offset=1;
+  unsigned long data = 0;  irindex_t Max; offset=1;
   if (Raw_Count) {if (rawlen != Raw_Count) return RAW_COUNT_ERROR;}
   if(!IgnoreHeader) {
     if (Head_Mark) {
@@ -364,16 +672,19 @@ bool IRdecodeBase::decodeGeneric(unsigned char Raw_Count, unsigned int Head_Mark
   offset++;
   if (Head_Space) {if (!MATCH(rawbuf[offset],Head_Space)) return HEADER_SPACE_ERROR(Head_Space);}
 
+  // Tolerance limits are computed once here rather than in every MATCH in the loops below.
+  IRmatchWindow Zero_Mark(Mark_Zero), One_Space(Space_One);
   if (Mark_One) {//Length of a mark indicates data "0" or "1". Space_Zero is ignored.
+    IRmatchWindow One_Mark(Mark_One);
     offset=2;//skip initial gap plus header Mark.
     Max=rawlen;
     while (offset < Max) {
-      if (!MATCH(rawbuf[offset], Space_One)) return DATA_SPACE_ERROR(Space_One);
+      if (!One_Space.match(rawbuf[offset])) return DATA_SPACE_ERROR(Space_One);
       offset++;
-      if (MATCH(rawbuf[offset], Mark_One)) {
+      if (One_Mark.match(rawbuf[offset])) {
         data = (data << 1) | 1;
       } 
-      else if (MATCH(rawbuf[offset], Mark_Zero)) {
+      else if (Zero_Mark.match(rawbuf[offset])) {
         data <<= 1;
       } 
       else return DATA_MARK_ERROR(Mark_Zero);
@@ -384,13 +695,14 @@ bool IRdecodeBase::decodeGeneric(unsigned char Raw_Count, unsigned int Head_Mark
   else {//Mark_One was 0 therefore length of a space indicates data "0" or "1".
     Max=rawlen-1; //ignore stop bit
     offset=3;//skip initial gap plus two header items
+    IRmatchWindow Zero_Space(Space_Zero);
     while (offset < Max) {
-      if (!MATCH (rawbuf[offset],Mark_Zero)) return DATA_MARK_ERROR(Mark_Zero);
+      if (!Zero_Mark.match(rawbuf[offset])) return DATA_MARK_ERROR(Mark_Zero);
       offset++;
-      if (MATCH(rawbuf[offset],Space_One)) {
+      if (One_Space.match(rawbuf[offset])) {
         data = (data << 1) | 1;
       } 
-      else if (MATCH (rawbuf[offset],Space_Zero)) {
+      else if (Zero_Space.match(rawbuf[offset])) {
         data <<= 1;
       } 
       else return DATA_SPACE_ERROR(Space_Zero);
@@ -403,6 +715,211 @@ bool IRdecodeBase::decodeGeneric(unsigned char Raw_Count, unsigned int Head_Mark
   return true;
 }
 
+/*
+ * Decodes a protocol from its description. The raw sample count is the gap, two for the header,
+ * two per bit less the final space which ends up as the next gap, and two more if there
+ * is a stop bit. If the description has no fixed number of bits then the count isn't checked.
+ */
+bool IRdecodeBase::decodeGeneric(const IRprotocol *Protocol) {
+  IRprotocol P; memcpy_P(&P, Protocol, sizeof(P));
+  irindex_t Raw_Count=0;
+  if (P.Num_Bits) Raw_Count=2*P.Num_Bits+2+(P.Use_Stop? 2: 0);
+  return decodeGeneric(Raw_Count, P.Head_Mark, P.Head_Space, (P.Mark_One==P.Mark_Zero)? 0: P.Mark_One, 
+                       P.Mark_Zero, P.Space_One, P.Space_Zero);
+}
+
+IRdecodePayload::IRdecodePayload(const IRprotocol *Protocol) {
+  this->Protocol=Protocol;
+  Reset();
+}
+
+void IRdecodePayload::Reset(void) {
+  IRdecodeBase::Reset();
+  memset(payload,0,sizeof(payload));
+  payload_bits=0;
+}
+
+/*
+ * decodeGeneric checks every interval so the bits only need to be collected. Each is
+ * a one if it matches the one length of whichever of mark or space carries the data.
+ */
+bool IRdecodePayload::decode(void) {
+  IRLIB_ATTEMPT_MESSAGE(F("Payload"));
+  if (!decodeGeneric(Protocol)) return false;
+  IRprotocol P; memcpy_P(&P, Protocol, sizeof(P));
+  bool Space_Data= (P.Mark_One==P.Mark_Zero);
+  IRmatchWindow One(Space_Data? P.Space_One: P.Mark_One);
+  irindex_t Max= Space_Data? rawlen-1: rawlen;
+  memset(payload,0,sizeof(payload));
+  payload_bits=0;
+  for(offset= Space_Data? 4: 3; offset<Max; offset+=2) {
+    if (payload_bits == 8*IRLIB_PAYLOAD_BYTES) return IRLIB_REJECTION_MESSAGE(F("number of bits"));
+    if (One.match(rawbuf[offset])) payload[payload_bits/8] |= 0x80>>(payload_bits%8);
+    payload_bits++;
+  }
+  bits= (payload_bits>255)? 255: payload_bits;
+  return true;
+}
+
+void IRanalyzer::Reset(void) {
+  memset(this,0,sizeof(*this));
+}
+
+/*
+ * A time joins the first cluster whose mean it matches. The captures are of one remote
+ * so there are few lengths and a handful of clusters is enough.
+ */
+void IRanalyzer::put(cluster_t *C, unsigned char &Num, unsigned int &Others, unsigned int Time) {
+  unsigned char i;
+  for (i = 0; i < Num; i++) {
+    unsigned int Mean=mean(C[i]);
+    if (MATCH(Time,Mean)) break;
+  }
+  if (i == Num) {
+    if (Num == IRLIB_ANALYZE_CLUSTERS) {Others++; return;}
+    Num++;
+  }
+  C[i].Sum+=Time; C[i].Count++;
+}
+
+bool IRanalyzer::add(IRdecodeBase *Capture) {
+  irindex_t Len=Capture->rawlen;
+  if (Len < 12) return false;       // a repeat code or noise
+  if (!Captures) Raw_Len=Len;
+  else if (Raw_Len != Len) Raw_Len=0;
+  Captures++;
+  Head_Mark.Sum+=Capture->rawbuf[1]; Head_Mark.Count++;
+  Head_Space.Sum+=Capture->rawbuf[2]; Head_Space.Count++;
+  for (irindex_t i = 3; i < Len; i++) {
+    if (i & 1) put(Marks,Num_Marks,Others,Capture->rawbuf[i]);
+    else put(Spaces,Num_Spaces,Others,Capture->rawbuf[i]);
+  }
+  return true;
+}
+
+/*
+ * Sorts the clusters shortest first and returns how many of them hold at least one in
+ * eight of the times. Those are the symbols. The rest are glitches.
+ */
+unsigned char IRanalyzer::symbols(cluster_t *C, unsigned char Num, unsigned int &Total) {
+  Total=0;
+  for (unsigned char i = 0; i < Num; i++) {
+    Total+=C[i].Count;
+    for (unsigned char j = i; j > 0 && mean(C[j]) < mean(C[j-1]); j--) {
+      cluster_t T=C[j]; C[j]=C[j-1]; C[j-1]=T;
+    }
+  }
+  unsigned char Found=0;
+  for (unsigned char i = 0; i < Num; i++) if (8*C[i].Count >= Total) C[Found++]=C[i];
+  return Found;
+}
+
+bool IRanalyzer::analyze(IRprotocol *Result, unsigned char kHz) {
+  cluster_t M[IRLIB_ANALYZE_CLUSTERS], S[IRLIB_ANALYZE_CLUSTERS];
+  unsigned int Mark_Total, Space_Total;
+  memcpy(M,Marks,sizeof(M)); memcpy(S,Spaces,sizeof(S));
+  unsigned char Num_M=symbols(M,Num_Marks,Mark_Total), Num_S=symbols(S,Num_Spaces,Space_Total);
+  if (!Captures || 8*Others > Mark_Total+Space_Total) return false;
+  IRprotocol &P=*Result;
+  P.Head_Mark=mean(Head_Mark); P.Head_Space=mean(Head_Space);
+  P.Max_Extent=0; P.kHz=kHz;
+  if (Num_M == 2 && Num_S == 1) {
+    P.Mark_Zero=mean(M[0]); P.Mark_One=mean(M[1]);
+    P.Space_Zero=P.Space_One=mean(S[0]);
+    P.Use_Stop=false;
+    P.Num_Bits=Raw_Len? (Raw_Len-2)/2: 0;
+    return MATCH(P.Head_Space,P.Space_One);  // decodeGeneric takes the header space as a data space
+  }
+  if (Num_M == 1 && Num_S == 2) {
+    P.Mark_Zero=P.Mark_One=mean(M[0]);
+    P.Space_Zero=mean(S[0]); P.Space_One=mean(S[1]);
+    P.Use_Stop=true;
+    P.Num_Bits=Raw_Len? (Raw_Len-4)/2: 0;
+    return true;
+  }
+  return false;
+}
+
+void IRanalyzer::DumpResults(unsigned char kHz) {
+#ifdef USE_DUMP
+  Serial.print(F("Captures:")); Serial.print(Captures,DEC);
+  Serial.print(F(" Head: m")); Serial.print(mean(Head_Mark),DEC);
+  Serial.print(F(" s")); Serial.println(mean(Head_Space),DEC);
+  for (unsigned char i = 0; i < Num_Marks; i++) {
+    Serial.print(F("  Mark ")); Serial.print(mean(Marks[i]),DEC);
+    Serial.print(F(" x")); Serial.println(Marks[i].Count,DEC);
+  }
+  for (unsigned char i = 0; i < Num_Spaces; i++) {
+    Serial.print(F("  Space ")); Serial.print(mean(Spaces[i]),DEC);
+    Serial.print(F(" x")); Serial.println(Spaces[i].Count,DEC);
+  }
+  if (Others) {Serial.print(F("  Unmatched ")); Serial.println(Others,DEC);}
+  IRprotocol P;
+  if (!analyze(&P,kHz)) {
+    Serial.println(F("Not a pulse width or pulse distance code. Try IRdecodeHash."));
+    return;
+  }
+  Serial.print(F("const IRprotocol IRprotocol_Unknown PROGMEM={"));
+  Serial.print(P.Head_Mark,DEC); Serial.print(F(", ")); Serial.print(P.Head_Space,DEC); Serial.print(F(", "));
+  Serial.print(P.Mark_One,DEC); Serial.print(F(", ")); Serial.print(P.Mark_Zero,DEC); Serial.print(F(", "));
+  Serial.print(P.Space_One,DEC); Serial.print(F(", ")); Serial.print(P.Space_Zero,DEC); Serial.print(F(", 0, "));
+  Serial.print(P.kHz,DEC); Serial.print(F(", ")); Serial.print(P.Num_Bits,DEC);
+  Serial.println(P.Use_Stop? F(", true};"): F(", false};"));
+#else
+  DumpUnavailable();
+#endif
+}
+
+/*
+ * Rather than letting each decoder in turn rescan the buffer, the frame is classified
+ * once by its raw sample count and header. Each test is one that the decoder itself
+ * makes before it will accept a frame, so a decoder is only skipped when it would have
+ * failed anyway. The candidates are still tried in the original order in case more
+ * than one of them matches, which means results are the same as before.
+ * If you add a protocol below, either give it a candidate bit or call it unconditionally.
+ */
+#define MIN_RC5_SAMPLES 11
+#define MIN_RC6_SAMPLES 1
+#define IRDECODE_NEC		0x01
+#define IRDECODE_SONY		0x02
+#define IRDECODE_RC5		0x04
+#define IRDECODE_RC6		0x08
+#define IRDECODE_PANASONIC_OLD	0x10
+#define IRDECODE_NECX		0x20
+#define IRDECODE_JVC		0x40
+unsigned char IRdecode::candidates(void) {
+  unsigned int Mark=rawbuf[1], Space=rawbuf[2];
+  unsigned char Found=0;
+  switch(rawlen) {
+    case 4:  Found=IRDECODE_NEC; break; //NEC repeat
+    case 68:
+      if (MATCH(Space,564*8)) {
+        if (IgnoreHeader) Found=IRDECODE_NEC | IRDECODE_NECX;
+        else if (MATCH(Mark,564*16)) Found=IRDECODE_NEC;
+        else if (MATCH(Mark,564*8)) Found=IRDECODE_NECX;
+      }
+      break;
+    case 2*8+2: case 2*12+2: case 2*15+2: case 2*20+2:
+      if ((IgnoreHeader || MATCH(Mark,600*4)) && MATCH(Space,600)) Found=IRDECODE_SONY;
+      break;
+    case 48:
+      if ((IgnoreHeader || MATCH(Mark,833*4)) && MATCH(Space,833*4)) Found=IRDECODE_PANASONIC_OLD;
+      break;
+    case 36:
+      if ((IgnoreHeader || MATCH(Mark,525*16)) && MATCH(Space,525*8)) Found=IRDECODE_JVC;
+      break;
+    case 34: //JVC repeat has no header
+      if (IgnoreHeader || MATCH(Mark,525)) Found=IRDECODE_JVC;
+      break;
+  }
+  //RC5 and RC6 have no fixed length. RC5 starts with a mark of one to three units.
+  if (rawlen >= MIN_RC5_SAMPLES + 2 && (MATCH(Mark,RC5_T1) || MATCH(Mark,2*RC5_T1) 
+      || MATCH(Mark,3*RC5_T1) || (IgnoreHeader && Mark<RC5_T1))) Found|=IRDECODE_RC5;
+  if (rawlen >= MIN_RC6_SAMPLES && (IgnoreHeader || MATCH(Mark,RC6_HDR_MARK)) 
+      && MATCH(Space,RC6_HDR_SPACE)) Found|=IRDECODE_RC6;
+  return Found;
+}
+
 /*
  * This routine has been modified significantly from the original IRremote.
  * It assumes you've already called IRrecvBase::GetResults and it was true.
@@ -415,13 +932,14 @@ bool IRdecodeBase::decodeGeneric(unsigned char Raw_Count, unsigned int Head_Mark
  * Note: Don't forget to call IRrecvBase::resume(); after decoding is complete.
  */
 bool IRdecode::decode(void) {
-  if (IRdecodeNEC::decode()) return true;
-  if (IRdecodeSony::decode()) return true;
-  if (IRdecodeRC5::decode()) return true;
-  if (IRdecodeRC6::decode()) return true;
-  if (IRdecodePanasonic_Old::decode()) return true;
-  if (IRdecodeNECx::decode()) return true;
-  if (IRdecodeJVC::decode()) return true;
+  unsigned char Try=candidates();
+  if ((Try & IRDECODE_NEC) && IRdecodeNEC::decode()) return true;
+  if ((Try & IRDECODE_SONY) && IRdecodeSony::decode()) return true;
+  if ((Try & IRDECODE_RC5) && IRdecodeRC5::decode()) return true;
+  if ((Try & IRDECODE_RC6) && IRdecodeRC6::decode()) return true;
+  if ((Try & IRDECODE_PANASONIC_OLD) && IRdecodePanasonic_Old::decode()) return true;
+  if ((Try & IRDECODE_NECX) && IRdecodeNECx::decode()) return true;
+  if ((Try & IRDECODE_JVC) && IRdecodeJVC::decode()) return true;
 //if (IRdecodeADDITIONAL::decode()) return true;//add additional protocols here
 //Deliberately did not add hash code decoding. If you get decode_type==UNKNOWN and
 // you want to know a hash code you can call IRhash::decode() yourself.
@@ -440,7 +958,7 @@ bool IRdecodeNEC::decode(void) {
     decode_type = NEC;
     return true;
   }
-  if(!decodeGeneric(68, 564*16, 564*8, 0, 564, 564*3, 564)) return false;
+  if(!decodeGeneric(&IRprotocol_NEC)) return false;
   decode_type = NEC;
   return true;
 }
@@ -450,7 +968,7 @@ bool IRdecodeNEC::decode(void) {
 bool IRdecodeSony::decode(void) {
   IRLIB_ATTEMPT_MESSAGE(F("Sony"));
   if(rawlen!=2*8+2 && rawlen!=2*12+2 && rawlen!=2*15+2 && rawlen!=2*20+2) return RAW_COUNT_ERROR;
-  if(!decodeGeneric(0, 600*4, 600, 600*2, 600, 600,0)) return false;
+  if(!decodeGeneric(&IRprotocol_Sony)) return false;
   decode_type = SONY;
   return true;
 }
@@ -479,7 +997,7 @@ bool IRdecodeSony::decode(void) {
  */
 bool IRdecodePanasonic_Old::decode(void) {
   IRLIB_ATTEMPT_MESSAGE(F("Panasonic_Old"));
-  if(!decodeGeneric(48,833*4,833*4,0,833,833*3,833)) return false;
+  if(!decodeGeneric(&IRprotocol_Panasonic_Old)) return false;
   /*
    * The protocol spec says that the first 11 bits described the device and function.
    * The next 11 bits are the same thing only it is the logical Bitwise complement.
@@ -499,7 +1017,7 @@ bool IRdecodePanasonic_Old::decode(void) {
 
 bool IRdecodeNECx::decode(void) {
   IRLIB_ATTEMPT_MESSAGE(F("NECx"));  
-  if(!decodeGeneric(68,564*8,564*8,0,564,564*3,564)) return false;
+  if(!decodeGeneric(&IRprotocol_NECx)) return false;
   decode_type = NECX;
   return true;
 }
@@ -507,7 +1025,7 @@ bool IRdecodeNECx::decode(void) {
 // JVC does not send any header if there is a repeat.
 bool IRdecodeJVC::decode(void) {
   IRLIB_ATTEMPT_MESSAGE(F("JVC"));
-  if(!decodeGeneric(36,525*16,525*8,0,525,525*3,525)) 
+  if(!decodeGeneric(&IRprotocol_JVC)) 
   {
      IRLIB_ATTEMPT_MESSAGE(F("JVC Repeat"));
      if (rawlen==34) 
@@ -543,6 +1061,10 @@ bool IRdecodeJVC::decode(void) {
  * t1 is the time interval for a single bit in microseconds.
  * Returns ERROR if the measured time interval is not a multiple of t1.
  */
+IRdecodeRC::IRdecodeRC(void) {
+  t1_Cached=0;
+}
+
 IRdecodeRC::RCLevel IRdecodeRC::getRClevel(unsigned char *used, const unsigned int t1) {
   if (offset >= rawlen) {
     // After end of recorded buffer, assume SPACE.
@@ -551,15 +1073,21 @@ IRdecodeRC::RCLevel IRdecodeRC::getRClevel(unsigned char *used, const unsigned i
   unsigned int width = rawbuf[offset];
   IRdecodeRC::RCLevel val;
   if ((offset) % 2) val=MARK; else val=SPACE;
-  
+  // The MATCH limits only change when t1 does so they are kept between calls
+  if (t1 != t1_Cached) {
+    for (unsigned char i=0; i<3; i++) {
+      t1_Low[i]=MATCH_LOW((i+1)*t1); t1_High[i]=MATCH_HIGH((i+1)*t1);
+    }
+    t1_Cached=t1;
+  }
   unsigned char avail;
-  if (MATCH(width, t1)) {
+  if (width >= t1_Low[0] && width <= t1_High[0]) {
     avail = 1;
   } 
-  else if (MATCH(width, 2*t1)) {
+  else if (width >= t1_Low[1] && width <= t1_High[1]) {
     avail = 2;
   } 
-  else if (MATCH(width, 3*t1)) {
+  else if (width >= t1_Low[2] && width <= t1_High[2]) {
     avail = 3;
   } 
   else {
@@ -576,9 +1104,6 @@ IRdecodeRC::RCLevel IRdecodeRC::getRClevel(unsigned char *used, const unsigned i
   return val;   
 }
 
-#define MIN_RC5_SAMPLES 11
-#define MIN_RC6_SAMPLES 1
-
 bool IRdecodeRC5::decode(void) {
   IRLIB_ATTEMPT_MESSAGE(F("RC5"));
   if (rawlen < MIN_RC5_SAMPLES + 2) return RAW_COUNT_ERROR;
@@ -664,18 +1189,18 @@ bool IRdecodeRC6::decode(void) {
  * Use FNV hash algorithm: http://isthe.com/chongo/tech/comp/fnv/#FNV-param
  * Converts the raw code values into a 32-bit hash code.
  * Hopefully this code is unique for each button.
+ * With IRLIB_ROLLING_HASH the receiver has usually done the work already.
  */
-#define FNV_PRIME_32 16777619
-#define FNV_BASIS_32 2166136261
 // Compare two tick values, returning 0 if newval is shorter,
 // 1 if newval is equal, and 2 if newval is longer
 int IRdecodeHash::compare(unsigned int oldval, unsigned int newval) {
-  if (newval < oldval * .8) return 0;
-  if (oldval < newval * .8) return 2;
-  return 1;
+  return Hash_Compare(oldval,newval);
 }
 
 bool IRdecodeHash::decode(void) {
+#ifdef IRLIB_ROLLING_HASH
+  if (HashReady) {hash=rawhash; return true;}
+#endif
   hash = FNV_BASIS_32;
   for (int i = 1; i+2 < rawlen; i++) {
     hash = (hash * FNV_PRIME_32) ^ compare(rawbuf[i], rawbuf[i+2]);
@@ -684,23 +1209,196 @@ bool IRdecodeHash::decode(void) {
   return true;
 }
 
+//Compares the code of an entry with the one wanted. Negative if the entry comes before it.
+static int Action_Compare(const IRaction &Entry, IRTYPES Type, unsigned long Value) {
+  if (Entry.Type != Type) return (Entry.Type < Type)? -1: 1;
+  if (Entry.Value != Value) return (Entry.Value < Value)? -1: 1;
+  return 0;
+}
+
+bool IRfindAction(const IRaction *Table, unsigned int Count, IRTYPES Type, unsigned long Value, unsigned int *Action) {
+  unsigned int Low=0, High=Count;
+  while (Low < High) {
+    unsigned int Mid=Low+(High-Low)/2;
+    IRaction Entry; memcpy_P(&Entry, &Table[Mid], sizeof(Entry));
+    int Order=Action_Compare(Entry,Type,Value);
+    if (Order == 0) {*Action=Entry.Action; return true;}
+    if (Order < 0) Low=Mid+1; else High=Mid;
+  }
+  return false;
+}
+
+bool IRcheckActions(const IRaction *Table, unsigned int Count) {
+  IRaction Last, Entry;
+  for (unsigned int i = 0; i < Count; i++) {
+    memcpy_P(&Entry, &Table[i], sizeof(Entry));
+    if (i && Action_Compare(Last,Entry.Type,Entry.Value) >= 0) return false;
+    Last=Entry;
+  }
+  return true;
+}
+
+/*
+ * IRdecodeStream follows each protocol below through the frame one interval at a time
+ * and drops it from Alive as soon as an interval doesn't fit. Each must have a header.
+ * Lengths is a bit mask of the allowed numbers of bits for a protocol whose description
+ * doesn't fix it. Protocols are listed in the order IRdecode tries them.
+ */
+#define SONY_LENGTHS ((1UL<<8) | (1UL<<12) | (1UL<<15) | (1UL<<20))
+static const struct {const IRprotocol *Protocol; IRTYPES Type; unsigned long Lengths;} Stream_Protocols[IRSTREAM_PROTOCOLS]={
+  {&IRprotocol_NEC, NEC, 0},
+  {&IRprotocol_Sony, SONY, SONY_LENGTHS},
+  {&IRprotocol_Panasonic_Old, PANASONIC_OLD, 0},
+  {&IRprotocol_NECx, NECX, 0},
+  {&IRprotocol_JVC, JVC, 0}
+};
+
+IRdecodeStream::IRdecodeStream(void) {
+  Frame=Fed=0; Claimed=false;
+  Reset();
+}
+
+void IRdecodeStream::Reset(void) {
+  IRdecodeBase::Reset();
+  Count=0;
+  Alive=(1<<IRSTREAM_PROTOCOLS)-1;
+  Done=0;
+  for(unsigned char p=0; p<IRSTREAM_PROTOCOLS; p++) {Data[p]=0; Bit_Count[p]=0;}
+}
+
+/* Reports the first protocol in Ended as long as no other is still matching and could
+ * go on to become a longer frame. JVC for example looks like the start of NEC.
+ */
+bool IRdecodeStream::found(unsigned char Ended) {
+  if (!Ended || (Alive & ~Ended)) return false;
+  unsigned char p=0;
+  while (!(Ended & (1<<p))) p++;
+  decode_type=Stream_Protocols[p].Type;
+  value=Data[p];
+  bits=Bit_Count[p];
+  return true;
+}
+
+/*
+ * Index 0 is the gap and 1 and 2 are the header. After that, if the space carries the data
+ * then odd entries are marks which must be Mark_Zero and each even entry completes a bit.
+ * If the mark carries the data it is the other way round and spaces must be Space_One.
+ * Either way bit n is complete at entry 2n+1 or 2n+2. A protocol is Done when it has all
+ * the bits it can have. After that only its stop mark may follow.
+ */
+bool IRdecodeStream::feed(unsigned int Duration) {
+  irindex_t i=Count++;
+  if (i==0 || decode_type!=UNKNOWN) return false;
+  for(unsigned char p=0; p<IRSTREAM_PROTOCOLS; p++) {
+    unsigned char Bit=1<<p;
+    if (!(Alive & Bit)) continue;
+    IRprotocol P; memcpy_P(&P, Stream_Protocols[p].Protocol, sizeof(P));
+    bool Space_Data=(P.Mark_One==P.Mark_Zero);
+    if (Done & Bit) {
+      if (P.Use_Stop && i==2*Bit_Count[p]+3 && MATCH(Duration,P.Mark_One)) continue;
+    } else if (i==1) {
+      if (IgnoreHeader || MATCH(Duration,P.Head_Mark)) continue;
+    } else if (i==2) {
+      if (Stream_Protocols[p].Type==NEC && MATCH(Duration,NEC_RPT_SPACE)) {
+        Data[p]=REPEAT; Alive=Done=Bit;
+        return found(Bit);
+      }
+      if (MATCH(Duration,P.Head_Space)) continue;
+    } else if ((i & 1) == Space_Data) {
+      if (MATCH(Duration,Space_Data? P.Mark_Zero: P.Space_One)) continue;
+    } else {
+      if (MATCH(Duration,Space_Data? P.Space_One: P.Mark_One)) Data[p]=(Data[p]<<1) | 1;
+      else if (MATCH(Duration,Space_Data? P.Space_Zero: P.Mark_Zero)) Data[p]<<=1;
+      else {Alive&= ~Bit; continue;}
+      unsigned char Bits=Bit_Count[p]=(i-1)/2;
+      unsigned long Lengths=Stream_Protocols[p].Lengths;
+      if (Lengths? (Lengths>>Bits)==1: Bits==P.Num_Bits) Done|=Bit;
+      continue;
+    }
+    Alive&= ~Bit;
+  }
+  return found(Done);
+}
+
+/*
+ * A space so long that no protocol still matching could expect it ends the frame.
+ * If the mark carries the data, the frame may end after any allowed number of bits.
+ */
+bool IRdecodeStream::feedSpace(unsigned long So_Far) {
+  if (Count<4 || (Count & 1) || decode_type!=UNKNOWN) return false;
+  unsigned char Ended=Done & Alive;
+  for(unsigned char p=0; p<IRSTREAM_PROTOCOLS; p++) {
+    unsigned char Bit=1<<p;
+    if (!(Alive & Bit) || (Done & Bit)) continue;
+    IRprotocol P; memcpy_P(&P, Stream_Protocols[p].Protocol, sizeof(P));
+    if (So_Far<=MATCH_HIGH(max(P.Space_One,P.Space_Zero))) return false; //could still be a bit
+    unsigned long Lengths=Stream_Protocols[p].Lengths;
+    if (P.Mark_One!=P.Mark_Zero && Lengths && ((Lengths>>Bit_Count[p]) & 1)) Ended|=Bit;
+  }
+  Alive=Ended;
+  return found(Ended);
+}
+
+bool IRdecodeStream::decode(void) {
+  IRLIB_ATTEMPT_MESSAGE(F("Stream"));
+  irindex_t Len=rawlen;
+  Reset(); rawlen=Len;
+  for(irindex_t i=0; i<rawlen; i++) {
+    if (feed(rawbuf[i])) return true;
+  }
+  return feedSpace(0xffffffff); //the gap ends the last space
+}
+
 /* We have created a new receiver base class so that we can use its code to implement
  * additional receiver classes in addition to the original IRremote code which used
  * 50us interrupt sampling of the input pin. See IRrecvLoop and IRrecvPCI classes
  * below. IRrecv is the original receiver class with the 50us sampling.
  */
-IRrecvBase::IRrecvBase(unsigned char recvpin)
+IRrecvBase::IRrecvBase(void) {
+  params=&irparams;
+}
+IRrecvBase::IRrecvBase(unsigned char recvpin, volatile irparams_t *State)
 {
-  irparams.recvpin = recvpin;
+  params=State? State: &irparams;
+  params->recvpin = recvpin;
   Init();
 }
 void IRrecvBase::Init(void) {
-  irparams.blinkflag = 0;
+  params->blinkflag = 0;
   Mark_Excess=100;
+  //IRrecvLoop needs no enableIRIn so be ready to record into the first slot
+  params->head = params->tail = 0;
+  params->ended = 0xff;
+  params->rawbuf = (irsample_t *)params->slots[0];
+  params->rawlen = 0;
+  params->expected = 0; params->endspace = 0;
+#ifdef IRLIB_ROLLING_HASH
+  params->hashtick = USECPERSAMPLE; params->hashexcess = Mark_Excess;
+#endif
+  params->rcvstate = STATE_IDLE;
 }
 
 unsigned char IRrecvBase::getPinNum(void){
-  return irparams.recvpin;
+  return params->recvpin;
+}
+
+unsigned char IRrecvBase::getDroppedFrames(void){
+  return params->dropped;
+}
+
+unsigned char IRrecvBase::getOverflows(void){
+  return params->overflows;
+}
+
+/* Number of frames completed so far, modulo 256. IRrecvPCI::GetResults may see that a
+ * frame has ended before the handler does. It cannot change head so it sets ended instead.
+ * Only call this from the sketch side, never from an interrupt.
+ */
+static unsigned char Frames_Done(volatile irparams_t &Rcv) {
+  unsigned char Head=Rcv.head;
+  if (Rcv.ended==Head) return Head+1;
+  Rcv.ended=Head-1; //keep it from matching head as head moves on
+  return Head;
 }
 
 /* Any receiver class must implement a GetResults method that will return true when a complete code
@@ -711,8 +1409,26 @@ unsigned char IRrecvBase::getPinNum(void){
  * value in Time_per_Ticks.
  */
 bool IRrecvBase::GetResults(IRdecodeBase *decoder, const unsigned int Time_per_Tick) {
+  volatile irparams_t &Rcv=*params;
   decoder->Reset();//clear out any old values.
-  decoder->rawlen = irparams.rawlen;
+  unsigned char Slot=Rcv.tail % IRLIB_CAPTURE_SLOTS;
+  decoder->rawlen = Rcv.slotlen[Slot];
+#ifdef IRLIB_ROLLING_HASH
+  decoder->HashReady= (Rcv.hashtick==Time_per_Tick && Rcv.hashexcess==Mark_Excess);
+  decoder->rawhash=Rcv.slothash[Slot];
+#endif
+  //A decoder using the receiver's buffers decodes the completed slot where it is.
+#ifdef IRLIB_COMPACT_CAPTURE
+  if (!decoder->ExtnBuf) decoder->rawbuf=Rcv.view;
+#elif defined(IRLIB_VIEW_CAPTURE)
+  //Nothing to copy. The view converts each interval as the decoder reads it.
+  if (!decoder->ExtnBuf) {
+    decoder->rawbuf.set(Rcv.slots[Slot],Time_per_Tick,Mark_Excess);
+    return true;
+  }
+#else
+  if (!decoder->ExtnBuf) decoder->rawbuf=Rcv.slots[Slot];
+#endif
 /* Typically IR receivers over-report the length of a mark and under-report the length of a space.
  * This routine adjusts for that by subtracting Mark_Excess from recorded marks and
  * deleting it from a recorded spaces. The amount of adjustment used to be defined in IRLibMatch.h.
@@ -720,19 +1436,134 @@ bool IRrecvBase::GetResults(IRdecodeBase *decoder, const unsigned int Time_per_T
  * By copying the the values from irparams to decoder we can call IRrecvBase::resume 
  * immediately while decoding is still in progress.
  */
-  for(unsigned char i=0; i<irparams.rawlen; i++) {
-    decoder->rawbuf[i]=irparams.rawbuf[i]*Time_per_Tick + ( (i % 2)? -Mark_Excess:Mark_Excess);
+  for(irindex_t i=0; i<decoder->rawlen; i++) {
+    RAWBUF_OF(decoder)[i]=Sample(Rcv,Slot,i)*Time_per_Tick + ( (i % 2)? -Mark_Excess:Mark_Excess);
   }
   return true;
 }
 
+/* Feeds a stream decoder whatever has been recorded of the oldest frame not resumed,
+ * while it is still arriving. Returns true as soon as the decoder recognizes it. If it
+ * ends without being recognized it is handed over as GetResults would with decode_type
+ * UNKNOWN so you can try other decoders. Either way call resume when you are done. If
+ * you don't, the next call releases it once it has ended, so that GetEarlyResults
+ * can simply be called over and over. Don't mix it with GetResults.
+ * Entries below rawlen are final so they are read in place. The length so far of the
+ * space being timed lets a Sony frame end long before the gap does.
+ */
+bool IRrecvBase::GetEarlyResults(IRdecodeStream *decoder, const unsigned int Time_per_Tick) {
+  volatile irparams_t &Rcv=*params;
+  if (decoder->Claimed && Frames_Done(Rcv) != Rcv.tail) resume();
+  unsigned char Done=Frames_Done(Rcv);
+  unsigned char Head; irindex_t Len; rcvstate_t State; unsigned long Timer;
+  do {
+    Head=Rcv.head; Len=Rcv.rawlen; State=Rcv.rcvstate; Timer=Rcv.timer;
+  } while (Head != Rcv.head || Len != Rcv.rawlen || Timer != Rcv.timer);
+  bool Complete= Done != Rcv.tail;
+  //enableIRIn starts the count again so also start again if the frame got shorter
+  if (decoder->Frame != Rcv.tail || (!Complete && Head == decoder->Frame && Len < decoder->Fed)) {
+    decoder->Frame=Rcv.tail; decoder->Fed=0; decoder->Claimed=false;
+    decoder->Reset();
+  }
+  if (decoder->Claimed) return false; //already reported and still arriving
+  unsigned char Slot=decoder->Frame % IRLIB_CAPTURE_SLOTS;
+  if (Complete) Len=Rcv.slotlen[Slot];
+  else if (Head != decoder->Frame) Len=0; //hasn't started yet
+  while (decoder->Fed < Len) {
+    irindex_t i=decoder->Fed++;
+    if (decoder->feed(Sample(Rcv,Slot,i)*Time_per_Tick + ( (i % 2)? -Mark_Excess:Mark_Excess))) {
+      decoder->Claimed=true;
+      return true;
+    }
+  }
+  if (Complete) {
+    decoder->Claimed=true;
+    if (!decoder->feedSpace(0xffffffff)) IRrecvBase::GetResults(decoder,Time_per_Tick);
+    return true;
+  }
+  unsigned long Space=0;
+  if (Head != decoder->Frame) return false;
+  if (State == STATE_SPACE) Space=Timer*Time_per_Tick;                 //IRrecv counts ticks since the mark ended
+  else if (State == STATE_RUNNING && Len && !(Len & 1)) Space=micros()-Timer; //IRrecvPCI remembers when it ended
+  if (Space && decoder->feedSpace(Space+Mark_Excess)) {
+    decoder->Claimed=true;
+    return true;
+  }
+  return false;
+}
+
 void IRrecvBase::enableIRIn(void) { 
-  pinMode(irparams.recvpin, INPUT);
+  volatile irparams_t &Rcv=*params;
+  pinMode(Rcv.recvpin, INPUT);
+  Rcv.head=Rcv.tail=0;
+  Rcv.ended=0xff;
+  Rcv.dropped=Rcv.overflows=0;
+  Rcv.rcvstate=STATE_STOP;
+#ifdef IRLIB_ROLLING_HASH
+  Rcv.hashtick=USECPERSAMPLE; Rcv.hashexcess=Mark_Excess;
+#endif
   resume();
 }
 
+/* Releases the frame handed over by GetResults. If the receiver stopped because
+ * every slot was full it restarts in the slot just freed. If it is still recording
+ * into another slot it carries on undisturbed.
+ */
 void IRrecvBase::resume() {
-  irparams.rawlen = 0;
+  volatile irparams_t &Rcv=*params;
+  if (Frames_Done(Rcv) != Rcv.tail) Rcv.tail++;
+  if (Rcv.rcvstate == STATE_STOP) {
+    Rcv.rawbuf = (irsample_t *)Rcv.slots[Rcv.head % IRLIB_CAPTURE_SLOTS];
+    Rcv.rawlen = 0;
+    Rcv.expected = 0; Rcv.endspace = 0;
+    Rcv.rcvstate = STATE_IDLE;
+  }
+}
+
+/* The frame in rawbuf is complete. Record its length and move on to the next slot if
+ * GetResults has not still got it. Otherwise stop until resume is called.
+ * Only ever call this from the one place that records into rawbuf.
+ */
+bool do_FrameDone(volatile irparams_t &Rcv) {
+  Rcv.slotlen[Rcv.head % IRLIB_CAPTURE_SLOTS] = Rcv.rawlen;
+#ifdef IRLIB_ROLLING_HASH
+  Rcv.slothash[Rcv.head % IRLIB_CAPTURE_SLOTS] = Rcv.hash;
+#endif
+  Rcv.head++;
+  if ((unsigned char)(Rcv.head - Rcv.tail) >= IRLIB_CAPTURE_SLOTS) {
+    Rcv.rcvstate = STATE_STOP;
+    return false;
+  }
+  Rcv.rawbuf = (irsample_t *)Rcv.slots[Rcv.head % IRLIB_CAPTURE_SLOTS];
+  Rcv.rawlen = 0;
+  Rcv.expected = 0; Rcv.endspace = 0;
+  Rcv.rcvstate = STATE_IDLE;
+  return true;
+}
+
+/* Frames of most protocols have a fixed number of intervals which we can tell from the
+ * header, so there is no need to wait for the gap. Where two protocols have headers
+ * close enough to match both, we expect the longer frame. The shorter one still ends
+ * at the gap as before. Sony frames may be several lengths but none of its spaces
+ * is as long as its header mark. The header is uncorrected by Mark_Excess which the
+ * tolerance easily covers. Limits are compile time constants so this is quick enough
+ * for an interrupt.
+ */
+#define PREDICT(Mark,Space,Count) \
+  if (IRmatchConst<Mark>::match(Head_Mark) && IRmatchConst<Space>::match(Head_Space) && Count>Expected) Expected=Count
+void do_Predict(volatile irparams_t &Rcv, const unsigned int Time_per_Tick) {
+#ifdef IRLIB_PREDICT_END
+  unsigned int Head_Mark=Rcv.rawbuf[1]*Time_per_Tick, Head_Space=Rcv.rawbuf[2]*Time_per_Tick;
+  unsigned char Expected=0;
+  PREDICT(564*16, NEC_RPT_SPACE, 4);
+  PREDICT(564*16, 564*8, 2*32+4);    //NEC
+  //Not NECx. Samsung36 and other longer frames begin with the same 4500/4500 header.
+  PREDICT(833*4,  833*4, 2*22+4);    //Panasonic_Old
+  PREDICT(525*16, 525*8, 2*16+4);    //JVC
+  Rcv.expected=Expected;
+  if (IRmatchConst<600*4>::match(Head_Mark) && IRmatchConst<600>::match(Head_Space)) 
+    Rcv.endspace=600*4/Time_per_Tick; //Sony
+#endif
 }
 
 /* This receiver uses no interrupts or timers. Other interrupt driven receivers
@@ -745,22 +1576,33 @@ void IRrecvBase::resume() {
  * use any digital input pin. Timing of this routine is only as accurate as your "micros();"
  */
 bool IRrecvLoop::GetResults(IRdecodeBase *decoder) {
+  volatile irparams_t &Rcv=*params;
   bool Finished=false;
   byte OldState=HIGH;byte NewState;
-  unsigned long StartTime, DeltaTime, EndTime;
+  unsigned long StartTime, DeltaTime, EndTime, Limit=10000;
+  //There is nothing recording in the background so a frame that was not resumed is finished with.
+  if (Rcv.rcvstate == STATE_STOP) resume();
   StartTime=micros();
-  while(irparams.rawlen<RAWBUF) {  //While the buffer not overflowing
-    while(OldState==(NewState=digitalRead(irparams.recvpin))) { //While the pin hasn't changed
-      if( (DeltaTime = (EndTime=micros()) - StartTime) > 10000) { //If it's a very long wait
-        if(Finished=irparams.rawlen) break; //finished unless it's the opening gap
+  while(Rcv.rawlen<RAWBUF) {  //While the buffer not overflowing
+    DeltaTime=0; EndTime=StartTime; //in case the pin has already changed
+    while(OldState==(NewState=digitalRead(Rcv.recvpin))) { //While the pin hasn't changed
+      if( (DeltaTime = (EndTime=micros()) - StartTime) > Limit) { //If it's a very long wait
+        if((Finished=Rcv.rawlen)) break; //finished unless it's the opening gap
       }
     }
     if(Finished) break;
-	do_Blink();
-    irparams.rawbuf[irparams.rawlen++]=DeltaTime;
+	do_Blink(Rcv);
+    Record(Rcv,(DeltaTime+USECPERSAMPLE/2)/USECPERSAMPLE);
+    if(Rcv.rawlen==3) {
+      do_Predict(Rcv,USECPERSAMPLE);
+      if(Rcv.endspace) Limit=Rcv.endspace*USECPERSAMPLE;
+    }
+    if(Rcv.rawlen==Rcv.expected) {Finished=true; break;}
     OldState=NewState;StartTime=EndTime;
   };
-  IRrecvBase::GetResults(decoder);
+  if(!Finished) Rcv.overflows++;
+  do_FrameDone(Rcv);
+  IRrecvBase::GetResults(decoder,USECPERSAMPLE);
   return true;
 }
 #ifdef USE_ATTACH_INTERRUPTS
@@ -775,61 +1617,151 @@ bool IRrecvLoop::GetResults(IRdecodeBase *decoder) {
  * assistance in developing this section of code.
  */
 
-IRrecvPCI::IRrecvPCI(unsigned char inum) {
-  Init();
+IRrecvPCI::IRrecvPCI(unsigned char inum, volatile irparams_t *State): IRrecvBase(Pin_from_Intr(inum),State) {
   intrnum=inum;
-  irparams.recvpin=Pin_from_Intr(inum);
+  slot=0xff;
+}
 
-  }
-void IRrecvPCI_Handler(){ 
+/* attachInterrupt cannot pass a parameter so each receiver gets its own small handler
+ * which passes its state to the real one. enableIRIn hands out the slots.
+ */
+static void PCI_Change(volatile irparams_t &Rcv);
+static volatile irparams_t *PCI_List[IRLIB_MAX_RECEIVERS];
+template <unsigned char N> void PCI_Handler(void) {PCI_Change(*PCI_List[N]);}
+static void (* const PCI_Handlers[IRLIB_MAX_RECEIVERS])(void)={PCI_Handler<0>,
+#if IRLIB_MAX_RECEIVERS>1
+  PCI_Handler<1>,
+#endif
+#if IRLIB_MAX_RECEIVERS>2
+  PCI_Handler<2>,
+#endif
+#if IRLIB_MAX_RECEIVERS>3
+  PCI_Handler<3>,
+#endif
+#if IRLIB_MAX_RECEIVERS>4
+  PCI_Handler<4>,
+#endif
+#if IRLIB_MAX_RECEIVERS>5
+  PCI_Handler<5>,
+#endif
+#if IRLIB_MAX_RECEIVERS>6
+  PCI_Handler<6>,
+#endif
+#if IRLIB_MAX_RECEIVERS>7
+  PCI_Handler<7>,
+#endif
+};
+
+/* The space after which IRrecvPCI takes a frame to have ended. A shorter one will do after
+ * a mark of a frame whose header we know. PCI_Change and PCI_Check_End must agree on this
+ * or the handler would record an edge into a frame that GetResults has already handed over.
+ */
+static inline unsigned long PCI_End_Space(irindex_t Len, unsigned int End_Space) {
+  return (!End_Space || (Len & 1))? 10000: (unsigned long)End_Space*USECPERSAMPLE;
+}
+
+static void PCI_Change(volatile irparams_t &Rcv) {
   unsigned long volatile ChangeTime=micros();
-  unsigned long DeltaTime=ChangeTime-irparams.timer;
-  switch(irparams.rcvstate) {
-    case STATE_STOP: return;
+  unsigned long DeltaTime=ChangeTime-Rcv.timer;
+  switch(Rcv.rcvstate) {
+    case STATE_STOP: 
+      //A mark after a long gap is a frame we have no room for
+      if (DeltaTime>10000 && !digitalRead(Rcv.recvpin)) Rcv.dropped++;
+      Rcv.timer=ChangeTime;
+      return;
     case STATE_RUNNING:
-	  do_Blink();
-      if (DeltaTime>10000) {
-        irparams.rcvstate=STATE_STOP; 
+	  do_Blink(Rcv);
+      if (DeltaTime>PCI_End_Space(Rcv.rawlen,Rcv.endspace)) {
         //Setting gap to 0 is a flag to let you know why we stopped For debugging purposes
-        //irparams.rawbuf[0]=0;
-        return;
+        //Rcv.rawbuf[0]=0;
+        //If there is a free slot this edge may be the start of the next frame
+        if(!do_FrameDone(Rcv)) {
+          if(!digitalRead(Rcv.recvpin)) Rcv.dropped++;
+          Rcv.timer=ChangeTime;
+          return;
+        }
+        if(digitalRead(Rcv.recvpin)) return; else Rcv.rcvstate=STATE_RUNNING;
       };
       break;
     case STATE_IDLE:
-       if(digitalRead(irparams.recvpin)) return; else irparams.rcvstate=STATE_RUNNING;
+       //Wait for a gap so that we don't start recording in the middle of a frame
+       if(DeltaTime<=10000) {Rcv.timer=ChangeTime; return;}
+       if(digitalRead(Rcv.recvpin)) return; else Rcv.rcvstate=STATE_RUNNING;
        break;
+    default: //not enabled, the other states are only used by IRrecv
+      return;
   };
-  irparams.rawbuf[irparams.rawlen]=DeltaTime;
-  irparams.timer=ChangeTime;
-  if(++irparams.rawlen>=RAWBUF) {
-    irparams.rcvstate=STATE_STOP;
+  Record(Rcv,(DeltaTime+USECPERSAMPLE/2)/USECPERSAMPLE);
+  Rcv.timer=ChangeTime;
+  if(Rcv.rawlen>=RAWBUF) {
+    Rcv.overflows++;
+    do_FrameDone(Rcv);
     //Setting gap to 1 is a flag to let you know why we stopped For debugging purposes
-    //irparams.rawbuf[0]=1;
+    //Rcv.rawbuf[0]=1;
   }
+  else if(Rcv.rawlen==3) do_Predict(Rcv,USECPERSAMPLE);
+  else if(Rcv.rawlen==Rcv.expected) do_FrameDone(Rcv);
+}
+
+bool IRrecvPCI::enableIRIn(void) {
+  if (slot == 0xff) {
+    for(slot=0; slot<IRLIB_MAX_RECEIVERS && PCI_List[slot] && PCI_List[slot]!=params; slot++);
+    if (slot == IRLIB_MAX_RECEIVERS) {slot=0xff; return false;} //no handler left
+    PCI_List[slot]=params;
+  }
+  //There has been no change to measure a gap from yet so pretend the last one was long ago
+  params->timer=micros()-20000;
+  IRrecvBase::enableIRIn();
+  return true;
 }
 
 void IRrecvPCI::resume(void) {
-  irparams.rcvstate = STATE_IDLE;
   IRrecvBase::resume();
-  irparams.timer=micros();
-  attachInterrupt(intrnum, IRrecvPCI_Handler, CHANGE);
+  if (slot != 0xff) attachInterrupt(intrnum, PCI_Handlers[slot], CHANGE);
 };
 
-bool IRrecvPCI::GetResults(IRdecodeBase *decoder) {
-  if(irparams.rcvstate==STATE_RUNNING) {
-    unsigned long ChangeTime=irparams.timer;
-    if( (micros()-ChangeTime) > 10000) {
-      irparams.rcvstate=STATE_STOP;
+/* The handler only runs on a change so the end of the last frame has to be noticed here.
+ * Only the handler may change head so instead we record the frame length and set ended.
+ * The handler will complete the same frame with the same length when the next change comes.
+ * The timer is four bytes and could change while we read it so we read until head and
+ * rawlen are the same before and after.
+ */
+static void PCI_Check_End(volatile irparams_t &Rcv) {
+  if (Frames_Done(Rcv) == Rcv.tail && Rcv.rcvstate==STATE_RUNNING) {
+    unsigned char Head; irindex_t Len; unsigned long Last; unsigned int End_Space;
+#ifdef IRLIB_ROLLING_HASH
+    unsigned long Hash;
+#endif
+    do {
+      Head=Rcv.head; Len=Rcv.rawlen; Last=Rcv.timer; End_Space=Rcv.endspace;
+#ifdef IRLIB_ROLLING_HASH
+      Hash=Rcv.hash;
+#endif
+    } while (Head != Rcv.head || Len != Rcv.rawlen);
+    if (Head == Rcv.tail && (micros()-Last) > PCI_End_Space(Len,End_Space)) {
       //Setting gap to 2 is a flag to let you know why we stopped For debugging purposes
-      //irparams.rawbuf[0]=2;
+      //Rcv.rawbuf[0]=2;
+      Rcv.slotlen[Head % IRLIB_CAPTURE_SLOTS]=Len;
+#ifdef IRLIB_ROLLING_HASH
+      Rcv.slothash[Head % IRLIB_CAPTURE_SLOTS]=Hash;
+#endif
+      Rcv.ended=Head;
     }
   }
-  if (irparams.rcvstate != STATE_STOP) return false;
-  detachInterrupt(intrnum);
-  IRrecvBase::GetResults(decoder);
+}
+
+bool IRrecvPCI::GetResults(IRdecodeBase *decoder) {
+  PCI_Check_End(*params);
+  if (Frames_Done(*params) == params->tail) return false;
+  IRrecvBase::GetResults(decoder,USECPERSAMPLE);
   return true;
 };
 
+bool IRrecvPCI::GetEarlyResults(IRdecodeStream *decoder) {
+  PCI_Check_End(*params);
+  return IRrecvBase::GetEarlyResults(decoder,USECPERSAMPLE);
+}
+
  /* This class facilitates detection of frequency of an IR signal. Requires a TSMP58000
  * or equivalent device connected to the hardware interrupt pin.
  * Create an instance of the object passing the interrupt number.
@@ -982,7 +1914,7 @@ void IRrecvBase::No_Output (void) {
 // enable/disable blinking of pin 13 on IR processing
 void IRrecvBase::blink13(bool blinkflag)
 {
-  irparams.blinkflag = blinkflag;
+  params->blinkflag = blinkflag;
   if (blinkflag)
      pinMode(BLINKLED, OUTPUT);
 }
@@ -990,9 +1922,9 @@ void IRrecvBase::blink13(bool blinkflag)
 //Do the actual blinking off and on
 //This is not part of IRrecvBase because it may need to be inside an ISR
 //and we cannot pass parameters to them.
-void do_Blink(void) {
-  if (irparams.blinkflag) {
-    if(irparams.rawlen % 2) {
+void do_Blink(volatile irparams_t &Rcv) {
+  if (Rcv.blinkflag) {
+    if(Rcv.rawlen % 2) {
       BLINKLED_ON();  // turn pin 13 LED on
     } 
     else {
@@ -1000,102 +1932,242 @@ void do_Blink(void) {
     }
   }
 }
+void do_Blink(void) {do_Blink(irparams);}
 #ifdef USE_IRRECV
 /*
  * The original IRrecv which uses 50s timer driven interrupts to sample input pin.
  */
-void IRrecv::resume() {
-  // initialize state machine variables
-  irparams.rcvstate = STATE_IDLE;
-  IRrecvBase::resume();
+/* Every IRrecv and IRrecvHybrid that has been enabled is sampled by the one timer interrupt.
+ * Each entry holds the state of one receiver, the port and bit of its pin where they can
+ * be read directly, and the level last seen so that the LED only changes with the input.
+ */
+enum irdata_t {IR_MARK=0, IR_SPACE=1};
+typedef struct {
+  volatile irparams_t *Rcv;
+#ifdef IR_RECV_READ_PORT
+  volatile irport_t *Port;
+  irport_t Mask;
+#endif
+  irdata_t Level;
+  bool Hybrid;
+} irrecv_entry_t;
+static irrecv_entry_t Recv_List[IRLIB_MAX_RECEIVERS];
+static volatile unsigned char Recv_Count;
+
+#ifdef IRLIB_ISR_STATS
+/* The total is halved along with the count so the average covers the most recent
+ * 16384 to 32768 interrupts, about one second, and never overflows.
+ */
+static unsigned int ISR_Min, ISR_Max, ISR_Count;
+static unsigned long ISR_Total;
+static void ISR_Stats_Reset(void) {
+  ISR_Min=0xffff; ISR_Max=0; ISR_Count=0; ISR_Total=0;
+}
+#endif
+
+/* IRrecvHybrid turns the timer interrupt off while every receiver is idle and notes when.
+ * The external interrupt on the first mark adds the idle time to the timers and turns
+ * the timer interrupt back on. It then samples the mark 50us later as IRrecv would.
+ * Hybrid_Mode is only set while all the receivers sampled are IRrecvHybrid.
+ */
+static volatile bool Hybrid_Mode, Hybrid_Armed;
+static volatile unsigned long Hybrid_Since;
+
+/* Adds a receiver to the timer interrupt or updates it. Call with interrupts off.
+ * Returns false if IRLIB_MAX_RECEIVERS others are already there.
+ */
+static bool Recv_Register(volatile irparams_t *Rcv, bool Hybrid) {
+  unsigned char i;
+  for(i=0; i<Recv_Count && Recv_List[i].Rcv!=Rcv; i++);
+  if (i == IRLIB_MAX_RECEIVERS) return false;
+  irrecv_entry_t &E=Recv_List[i];
+  E.Rcv=Rcv;
+#ifdef IR_RECV_READ_PORT
+  E.Port=(volatile irport_t *)portInputRegister(digitalPinToPort(Rcv->recvpin));
+  E.Mask=digitalPinToBitMask(Rcv->recvpin);
+#endif
+  E.Level=IR_SPACE;
+  E.Hybrid=Hybrid;
+  if (i == Recv_Count) Recv_Count++;
+  Hybrid_Mode=true;
+  for(i=0; i<Recv_Count; i++) if (!Recv_List[i].Hybrid) Hybrid_Mode=false;
+  return true;
 }
 
-void IRrecv::enableIRIn(void) {
+bool IRrecv::enableIRIn(void) {
   IRrecvBase::enableIRIn();
   // setup pulse clock timer interrupt
   cli();
+  if (!Recv_Register(params,false)) {sei(); return false;}
+#ifdef IRLIB_ROLLING_HASH
+  params->hashtick=USECPERTICK;
+#endif
+#ifdef IRLIB_ISR_STATS
+  ISR_Stats_Reset();
+#endif
+  Hybrid_Armed=true;
   IR_RECV_CONFIG_TICKS();
   IR_RECV_ENABLE_INTR;
   sei();
+  return true;
 }
 
 bool IRrecv::GetResults(IRdecodeBase *decoder) {
-  if (irparams.rcvstate != STATE_STOP) return false;
+  if (Frames_Done(*params) == params->tail) return false;
   IRrecvBase::GetResults(decoder,USECPERTICK);
   return true;
 }
 
+bool IRrecv::GetEarlyResults(IRdecodeStream *decoder) {
+  return IRrecvBase::GetEarlyResults(decoder,USECPERTICK);
+}
+
+#ifdef IRLIB_ISR_STATS
+void IRrecv::getISRCycles(unsigned int *Min, unsigned int *Avg, unsigned int *Max) {
+  cli();
+  *Min=(ISR_Count)? ISR_Min: 0;
+  *Avg=(ISR_Count)? ISR_Total/ISR_Count: 0;
+  *Max=ISR_Max;
+  ISR_Stats_Reset();
+  sei();
+}
+#endif
+
 #define _GAP 5000 // Minimum map between transmissions
 #define GAP_TICKS (_GAP/USECPERTICK)
 /*
- * This interrupt service routine is only used by IRrecv and may or may not be used by other
- * extensions of the IRrecBase. It is timer driven interrupt code to collect raw data.
+ * This is the timer driven code which collects raw data for one receiver each tick.
  * Widths of alternating SPACE, MARK are recorded in rawbuf. Recorded in ticks of 50 microseconds.
  * rawlen counts the number of entries recorded so far. First entry is the SPACE between transmissions.
  * As soon as a SPACE gets long, ready is set, state switches to IDLE, timing of SPACE continues.
  * As soon as first MARK arrives, gap width is recorded, ready is cleared, and new logging starts.
+ * Returns true if the receiver has been idle for at least a gap.
  */
-ISR(IR_RECV_INTR_NAME)
-{
-  enum irdata_t {IR_MARK=0, IR_SPACE=1};
-  irdata_t irdata = (irdata_t)digitalRead(irparams.recvpin);
-  irparams.timer++; // One more 50us tick
-  if (irparams.rawlen >= RAWBUF) {
+static inline bool Recv_Tick(irrecv_entry_t &E) {
+  volatile irparams_t &Rcv=*E.Rcv;
+#ifdef IR_RECV_READ_PORT
+  irdata_t irdata = (*E.Port & E.Mask)? IR_SPACE: IR_MARK;
+#else
+  irdata_t irdata = (irdata_t)digitalRead(Rcv.recvpin);
+#endif
+  Rcv.timer++; // One more 50us tick
+  if (Rcv.rawlen >= RAWBUF && Rcv.rcvstate != STATE_STOP) {
     // Buffer overflow
-    irparams.rcvstate = STATE_STOP;
+    Rcv.overflows++;
+    do_FrameDone(Rcv);
   }
-  switch(irparams.rcvstate) {
+  switch(Rcv.rcvstate) {
   case STATE_IDLE: // In the middle of a gap
     if (irdata == IR_MARK) {
-      if (irparams.timer < GAP_TICKS) {
+      if (Rcv.timer < GAP_TICKS) {
         // Not big enough to be a gap.
-        irparams.timer = 0;
+        Rcv.timer = 0;
       } 
       else {
         // gap just ended, record duration and start recording transmission
-        irparams.rawlen = 0;
-        irparams.rawbuf[irparams.rawlen++] = irparams.timer;
-        irparams.timer = 0;
-        irparams.rcvstate = STATE_MARK;
+        Rcv.rawlen = 0;
+        Record(Rcv,Rcv.timer);
+        Rcv.timer = 0;
+        Rcv.rcvstate = STATE_MARK;
       }
     }
     break;
   case STATE_MARK: // timing MARK
     if (irdata == IR_SPACE) {   // MARK ended, record time
-      irparams.rawbuf[irparams.rawlen++] = irparams.timer;
-      irparams.timer = 0;
-      irparams.rcvstate = STATE_SPACE;
+      Record(Rcv,Rcv.timer);
+      Rcv.timer = 0;
+      Rcv.rcvstate = STATE_SPACE;
+      // If that was the last mark of a frame we recognized, don't wait for the gap
+      if (Rcv.rawlen == Rcv.expected) do_FrameDone(Rcv);
     }
     break;
   case STATE_SPACE: // timing SPACE
     if (irdata == IR_MARK) { // SPACE just ended, record it
-      irparams.rawbuf[irparams.rawlen++] = irparams.timer;
-      irparams.timer = 0;
-      irparams.rcvstate = STATE_MARK;
+      Record(Rcv,Rcv.timer);
+      Rcv.timer = 0;
+      Rcv.rcvstate = STATE_MARK;
+      if (Rcv.rawlen == 3) do_Predict(Rcv,USECPERTICK);
     } 
     else { // SPACE
-      if (irparams.timer > GAP_TICKS) {
+      if (Rcv.timer > GAP_TICKS || (Rcv.endspace && Rcv.timer > Rcv.endspace)) {
         // big SPACE, indicates gap between codes
         // Mark current code as ready for processing
-        // Switch to STOP
+        // Switch to IDLE in the next slot or to STOP if there isn't one
         // Don't reset timer; keep counting space width
-        irparams.rcvstate = STATE_STOP;
+        do_FrameDone(Rcv);
       } 
     }
     break;
   case STATE_STOP: // waiting, measuring gap
     if (irdata == IR_MARK) { // reset gap timer
-      irparams.timer = 0;
+      if (Rcv.timer >= GAP_TICKS) Rcv.dropped++; // a frame began with no free slot
+      Rcv.timer = 0;
     }
     break;
+  default: // only used by IRrecvPCI
+    break;
+  }
+  // The LED only changes when the input does
+  if (irdata != E.Level) {
+    E.Level=irdata;
+    do_Blink(Rcv);
+  }
+  return Rcv.timer > GAP_TICKS && (Rcv.rcvstate == STATE_IDLE || Rcv.rcvstate == STATE_STOP);
+}
+
+/*
+ * This interrupt service routine is only used by IRrecv and may or may not be used by other
+ * extensions of the IRrecBase. It samples every receiver that has been enabled.
+ */
+ISR(IR_RECV_INTR_NAME)
+{
+  bool Idle=true;
+  for(unsigned char i=0; i<Recv_Count; i++) {
+    if (!Recv_Tick(Recv_List[i])) Idle=false;
   }
-  do_Blink();
+  if (Hybrid_Mode && Idle) {
+    IR_RECV_DISABLE_INTR;
+    Hybrid_Armed=false;
+    Hybrid_Since=micros();
+  }
+#ifdef IRLIB_ISR_STATS
+  unsigned int Cycles=IR_RECV_TIMER_COUNT()*IR_RECV_CYCLES_PER_COUNT;
+  if (Cycles<ISR_Min) ISR_Min=Cycles;
+  if (Cycles>ISR_Max) ISR_Max=Cycles;
+  ISR_Total+=Cycles;
+  if (++ISR_Count == 0x8000) {ISR_Count/=2; ISR_Total/=2;}
+#endif
+}
+
+#ifdef USE_ATTACH_INTERRUPTS
+IRrecvHybrid::IRrecvHybrid(unsigned char inum, volatile irparams_t *State): IRrecv(Pin_from_Intr(inum),State) {
+  intrnum=inum;
 }
+
+void IRrecvHybrid_Wake(void) {
+  if (Hybrid_Armed) return;
+  unsigned long Idle_Ticks=(micros()-Hybrid_Since)/USECPERTICK;
+  for(unsigned char i=0; i<Recv_Count; i++) Recv_List[i].Rcv->timer += Idle_Ticks;
+  Hybrid_Armed=true;
+  IR_RECV_CONFIG_TICKS();
+  IR_RECV_ENABLE_INTR;
+}
+
+bool IRrecvHybrid::enableIRIn(void) {
+  if (!IRrecv::enableIRIn()) return false;
+  cli();
+  Recv_Register(params,true);
+  sei();
+  attachInterrupt(intrnum, IRrecvHybrid_Wake, FALLING);
+  return true;
+}
+#endif
 #endif //end of ifdef USE_IRRECV
 /*
  * The hardware specific portions of IRsendBase
  */
 void IRsendBase::enableIROut(unsigned char khz) {
+ if (Recording) {Rec_kHz=khz; return;}
 //NOTE: the comments on this routine accompanied the original early version of IRremote library
 //which only used TIMER2. The parameters defined in IRLibTimer.h may or may not work this way.
   // Enables IR output.  The khz value controls the modulation frequency in kilohertz.
@@ -1117,6 +2189,7 @@ void IRsendBase::enableIROut(unsigned char khz) {
  }
 
 IRsendBase::IRsendBase () {
+ Recording=false;
  pinMode(IR_SEND_PWM_PIN, OUTPUT);  
  digitalWrite(IR_SEND_PWM_PIN, LOW); // When not sending PWM, we want it low    
 }
@@ -1128,17 +2201,178 @@ void  My_delay_uSecs(unsigned int T) {
 }
 
 void IRsendBase::mark(unsigned int time) {
+ if (Recording) {store(time,true); return;}
  IR_SEND_PWM_START;
  IR_SEND_MARK_TIME(time);
  Extent+=time;
 }
 
 void IRsendBase::space(unsigned int time) {
+ if (Recording) {store(time,false); return;}
  IR_SEND_PWM_STOP;
  My_delay_uSecs(time);
  Extent+=time;
 }
 
+#if defined(IR_SEND_BIT_BANG) && defined(__AVR__)
+/*
+ * Writing a bit to a PIN register toggles that output without touching the others on the
+ * port, so interrupts which use other pins of the same port don't interfere. OnTime and
+ * OffTime are the passes of the two delay loops. The cycles each instruction takes on an
+ * ATmega are given beside it. The frequency and duty are exact but an interrupt during the
+ * mark, such as the one for millis, stretches the carrier cycle it lands in.
+ */
+void IRsendBase::bitBangConfig(unsigned char khz) {
+  Pin_Toggle=portInputRegister(digitalPinToPort(IR_SEND_BIT_BANG));
+  Pin_Mask=digitalPinToBitMask(IR_SEND_BIT_BANG);
+  OnTime=IR_BIT_BANG_ON_LOOPS(khz);
+  OffTime=IR_BIT_BANG_OFF_LOOPS(khz);
+  unsigned int Period=3*(OnTime+OffTime)+8;
+  Periods_Scale=(F_CPU/15625*1024UL+Period/2)/Period; //F_CPU*65536/1000000 without overflow
+}
+
+void IRsendBase::bitBang(unsigned int time) {
+  unsigned int Count=((unsigned long)time*Periods_Scale)>>16;
+  if (!Count) return;
+  asm volatile(
+    "1: st %a[pin], %[mask]     \n\t" //2 pin goes high
+    "   mov __tmp_reg__, %[on]  \n\t" //1
+    "2: dec __tmp_reg__         \n\t" //1
+    "   brne 2b                 \n\t" //2, 1 on the last pass
+    "   st %a[pin], %[mask]     \n\t" //2 pin goes low
+    "   mov __tmp_reg__, %[off] \n\t" //1
+    "3: dec __tmp_reg__         \n\t" //1
+    "   brne 3b                 \n\t" //2, 1 on the last pass
+    "   sbiw %[count], 1        \n\t" //2
+    "   brne 1b                 \n\t" //2
+    : [count] "+w" (Count)
+    : [pin] "e" (Pin_Toggle), [mask] "r" (Pin_Mask), [on] "r" (OnTime), [off] "r" (OffTime)
+    : "memory");
+}
+#endif
+
+/*
+ * Plays the loaded frames together. Each emitter's gate follows its own frame while the
+ * carrier is on whenever any of them is in a mark. Times are measured from the start with
+ * micros() so that the time spent switching does not add up over the frame.
+ */
+void IRsendMulti::sendLoaded(void) {
+  if (!Loaded_kHz) return;
+#ifdef IR_SEND_BIT_BANG
+  //Bit-bang output is timed by the marks themselves so the frames go one after another
+  for(unsigned char i=0; i<Count; i++) {
+    if (!Emitters[i].Len) continue;
+    digitalWrite(Emitters[i].Pin, HIGH);
+    IRsendRaw::send(Emitters[i].Buf, Emitters[i].Len, Loaded_kHz);
+    digitalWrite(Emitters[i].Pin, LOW);
+  }
+#else
+  irindex_t Index[IRLIB_MAX_EMITTERS];
+  unsigned long Ends[IRLIB_MAX_EMITTERS]; //when each emitter's current interval ends
+  enableIROut(Loaded_kHz);
+  for(unsigned char i=0; i<Count; i++) {
+    Index[i]=0; Ends[i]=0;
+    if (Emitters[i].Len) {Ends[i]=Emitters[i].Buf[0]; digitalWrite(Emitters[i].Pin, HIGH);}
+  }
+  IR_SEND_PWM_START;
+  unsigned long Start=micros();
+  for(;;) {
+    unsigned long When=0xffffffffUL;
+    for(unsigned char i=0; i<Count; i++) if (Index[i] < Emitters[i].Len && Ends[i] < When) When=Ends[i];
+    if (When == 0xffffffffUL) break;
+    while (micros()-Start < When);
+    bool Lit=false;
+    for(unsigned char i=0; i<Count; i++) {
+      if (Index[i] >= Emitters[i].Len) continue;
+      if (Ends[i] <= When) {
+        if (++Index[i] < Emitters[i].Len) Ends[i]+=Emitters[i].Buf[Index[i]];
+        digitalWrite(Emitters[i].Pin, (Index[i] < Emitters[i].Len && !(Index[i] & 1))? HIGH: LOW);
+      }
+      Lit|= Index[i] < Emitters[i].Len && !(Index[i] & 1);
+    }
+    if (Lit) IR_SEND_PWM_START; else IR_SEND_PWM_STOP;
+  }
+  IR_SEND_PWM_STOP;
+#endif
+  for(unsigned char i=0; i<Count; i++) Emitters[i].Len=0;
+  Loaded_kHz=0;
+}
+
+#ifdef USE_IRSEND_ASYNC
+static IRsendAsync *Async_Sender;
+
+IRsendAsync::IRsendAsync(void) {
+  head=tail=0; Busy=false; Done=NULL;
+}
+
+/*
+ * The frame is recorded in microseconds then turned into carrier cycles so that the
+ * interrupt only has to count down. The slot is published by advancing head. If the
+ * interrupt finishes the previous frame in between, it starts this one itself.
+ */
+bool IRsendAsync::send(IRTYPES Type, unsigned long data, unsigned int data2) {
+#ifndef IR_SEND_INTR_NAME
+  IRsend::send(Type, data, data2);
+  return true;
+#else
+  if ((unsigned char)(head-tail) >= IRLIB_SEND_SLOTS) return false;
+  unsigned char h=head % IRLIB_SEND_SLOTS;
+  beginRecord(Slots[h], IRLIB_SEND_SLOT_LEN);
+  IRsend::send(Type, data, data2);
+  if (!endRecord()) return false;
+  for(irindex_t i=0; i<Rec_Len; i++) Slots[h][i]=((unsigned long)Slots[h][i]*Rec_kHz+500)/1000;
+  Lens[h]=Rec_Len; kHz[h]=Rec_kHz;
+  Async_Sender=this;
+  head++;
+  if (!Busy) {
+    Busy=true;
+    enableIROut(kHz[h]);
+    start();
+    IR_SEND_INTR_ENABLE;
+  }
+  return true;
+#endif
+}
+
+#ifdef IR_SEND_INTR_NAME
+//Begins the frame in slot tail. Intervals too short for one carrier cycle are skipped.
+void IRsendAsync::start(void) {
+  unsigned char t=tail % IRLIB_SEND_SLOTS;
+  for(Index=0; Index<Lens[t] && !Slots[t][Index]; Index++);
+  if (Index < Lens[t]) Left=Slots[t][Index];
+  else Left=1;
+  if (Index < Lens[t] && !(Index & 1)) IR_SEND_PWM_START; else IR_SEND_PWM_STOP;
+}
+
+void IRsendAsync::nextCycle(void) {
+  if (--Left) return;
+  unsigned char t=tail % IRLIB_SEND_SLOTS;
+  while (++Index < Lens[t] && !Slots[t][Index]);
+  if (Index < Lens[t]) {
+    Left=Slots[t][Index];
+    if (Index & 1) IR_SEND_PWM_STOP; else IR_SEND_PWM_START;
+    return;
+  }
+  IR_SEND_PWM_STOP;
+  tail++;
+  if (Done) Done();
+  if (head == tail) {
+    IR_SEND_INTR_DISABLE;
+    Busy=false;
+    return;
+  }
+  t=tail % IRLIB_SEND_SLOTS;
+  if (kHz[t] != kHz[(unsigned char)(tail-1) % IRLIB_SEND_SLOTS]) IR_SEND_CONFIG_KHZ(kHz[t]);
+  start();
+}
+
+ISR(IR_SEND_INTR_NAME)
+{
+  Async_Sender->nextCycle();
+}
+#endif
+#endif //USE_IRSEND_ASYNC
+
 /*
  * Various debugging routines
  */
@@ -1148,7 +2382,7 @@ void IRsendBase::space(unsigned int time) {
 void IRLIB_ATTEMPT_MESSAGE(const __FlashStringHelper * s) {Serial.print(F("Attempting ")); Serial.print(s); Serial.println(F(" decode:"));};
 void IRLIB_TRACE_MESSAGE(const __FlashStringHelper * s) {Serial.print(F("Executing ")); Serial.println(s);};
 byte IRLIB_REJECTION_MESSAGE(const __FlashStringHelper * s) { Serial.print(F(" Protocol failed because ")); Serial.print(s); Serial.println(F(" wrong.")); return false;};
-byte IRLIB_DATA_ERROR_MESSAGE(const __FlashStringHelper * s, unsigned char index, unsigned int value, unsigned int expected) {  
+byte IRLIB_DATA_ERROR_MESSAGE(const __FlashStringHelper * s, irindex_t index, unsigned int value, unsigned int expected) {  
  IRLIB_REJECTION_MESSAGE(s); Serial.print(F("Error occurred with rawbuf[")); Serial.print(index,DEC); Serial.print(F("]=")); Serial.print(value,DEC);
  Serial.print(F(" expected:")); Serial.println(expected,DEC); return false;
 };
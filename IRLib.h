@@ -54,6 +54,23 @@
  * comment out the following define to eliminate considerable program space.
  */
 #define USE_DUMP
+/* IRsendAsync sends from the overflow interrupt of the sending timer. Other libraries may
+ * define the same interrupt so it is only compiled if you uncomment the following line.
+ */
+//#define USE_IRSEND_ASYNC
+/* Receivers normally know a frame has ended only after a long gap of space. Uncomment this
+ * to have them recognize the header of NEC, JVC, Panasonic_Old and Sony frames and finish
+ * as soon as the last interval arrives. Any longer frame with one of those headers is then
+ * cut short. Many air conditioners and NEC variants send the 9000/4500 header of NEC, so
+ * leave it off if you capture such frames, for instance for IRdecodePayload. NECx is never
+ * predicted because Samsung36 and others share its 4500/4500 header but are longer.
+ */
+//#define IRLIB_PREDICT_END
+/* Uncomment to have the IRrecv interrupt time itself with the receive timer's counter so
+ * that IRrecv::getISRCycles can report how much of each 50us tick it uses. The count
+ * starts when the interrupt is due so it includes the entry overhead. Only for AVR timers.
+ */
+//#define IRLIB_ISR_STATS
 
 // Only used for testing; can remove virtual for shorter code
 #ifdef IRLIB_TEST
@@ -62,7 +79,68 @@
 #define VIRTUAL
 #endif
 
-#define RAWBUF 100 // Length of raw duration buffer (cannot exceed 255)
+/* Length of raw duration buffer. It may also be set on the compiler's command line, for
+ * instance to 400 for the long frames of IRdecodePayload.
+ */
+#ifndef RAWBUF
+#define RAWBUF 100
+#endif
+/* Type of rawlen and of every index into the raw buffer. It is a byte unless RAWBUF is more
+ * than 255, as air conditioner frames of 100 bits or more need. Reads of a two byte rawlen
+ * while the receiver is running are protected the same way as those of the timer.
+ */
+#if RAWBUF > 255
+typedef unsigned int irindex_t;
+#else
+typedef unsigned char irindex_t;
+#endif
+/* Number of raw duration buffers used by the receivers. With more than one, the receiver
+ * switches to a free buffer at the end of each frame and keeps recording while you decode,
+ * so frames which arrive close together such as repeat codes are not lost. Each additional
+ * buffer uses RAWBUF*2+1 bytes of RAM. With 1 the receiver stops until you call resume().
+ * Must be 1, 2, 4, 8 etc. IRrecvBase::getDroppedFrames tells you if you need more.
+ * It may also be set on the compiler's command line.
+ */
+#ifndef IRLIB_CAPTURE_SLOTS
+#define IRLIB_CAPTURE_SLOTS 1
+#endif
+/* Uncomment to record into the capture slots one byte per interval instead of two. IRrecv
+ * stores its 50us ticks, IRrecvPCI and IRrecvLoop store units of USECPERSAMPLE (64us).
+ * The gap is kept in full beside each slot. Any other interval too long for a byte reads
+ * back as 255 units, which no protocol has. Decoders still see microseconds: GetResults
+ * expands the frame into the decoder's buffer, or into a buffer of RAWBUF ints kept by
+ * the receiver for decoders that don't call UseExtnBuf. Each slot then costs RAWBUF+2 bytes rather than
+ * RAWBUF*2 but the shared buffer adds RAWBUF*2, so it saves RAM from 4 slots upwards.
+ */
+//#define IRLIB_COMPACT_CAPTURE
+/* Uncomment to have GetResults hand the completed slot to the decoder as it is, rather than
+ * first converting every interval to microseconds. rawbuf becomes an IRrawView which applies
+ * the tick length and Mark_Excess as each interval is read, so GetResults takes the same short
+ * time for any frame. Decode before you call resume because the slot is reused after that.
+ * rawbuf is read only in this mode. A decoder which changes it must call UseExtnBuf and
+ * GetResults then converts into that buffer as before. Not available with compact capture.
+ */
+//#define IRLIB_VIEW_CAPTURE
+/* Uncomment to have the receivers work out the hash of IRdecodeHash as each interval
+ * arrives. GetResults hands it to the decoder so IRdecodeHash::decode has nothing left to
+ * do once the frame ends. The hash is the same as decode would compute from rawbuf but
+ * only handed over if Mark_Excess hasn't changed since enableIRIn. It costs 4 bytes per
+ * capture slot and the interrupt a few multiplications at the end of each interval.
+ */
+//#define IRLIB_ROLLING_HASH
+/* Number of IRrecv or IRrecvHybrid receivers on different pins which can be enabled at the
+ * same time, and separately of IRrecvPCI receivers. No more than 8. Every receiver beyond
+ * the first needs its own irparams_t passed to its constructor. See IRLibRData.h.
+ * The one timer interrupt samples every IRrecv in turn so its time grows with each one
+ * enabled, by a little over half of what the first costs as the loop and entry are shared.
+ * The IRbench program in extras/host measures this and IRLIB_ISR_STATS measures it on the
+ * board. IRrecvPCI receivers each have their own interrupt and cost nothing extra.
+ * enableIRIn returns false for a receiver beyond the limit, which is then never sampled.
+ * The limit may also be set on the compiler's command line.
+ */
+#ifndef IRLIB_MAX_RECEIVERS
+#define IRLIB_MAX_RECEIVERS 1
+#endif
 
 typedef char IRTYPES; //formerly was an enum
 #define UNKNOWN 0
@@ -79,6 +157,41 @@ typedef char IRTYPES; //formerly was an enum
 
 const __FlashStringHelper *Pnames(IRTYPES Type); //Returns a character string that is name of protocol.
 
+/*
+ * Timing of a protocol that the generic send and decode routines can handle. The same
+ * description drives both directions. Descriptions are kept in flash with PROGMEM and
+ * are passed by address to IRsendBase::sendGeneric and IRdecodeBase::decodeGeneric.
+ * All times are in microseconds. If Mark_One and Mark_Zero are the same, the length of
+ * the space carries the data. Otherwise the length of the mark does.
+ */
+typedef struct {
+  unsigned int Head_Mark, Head_Space;   // zero if there is no header
+  unsigned int Mark_One, Mark_Zero, Space_One, Space_Zero;
+  unsigned long Max_Extent;             // total frame length to pad out to, zero if none
+  unsigned char kHz;
+  unsigned char Num_Bits;               // zero if the protocol allows different lengths
+  bool Use_Stop;                        // ends with a stop mark of Mark_One
+} IRprotocol;
+extern const IRprotocol IRprotocol_NEC PROGMEM;
+extern const IRprotocol IRprotocol_Sony PROGMEM;
+extern const IRprotocol IRprotocol_Sony8 PROGMEM; //same as Sony with a shorter frame
+extern const IRprotocol IRprotocol_Panasonic_Old PROGMEM;
+extern const IRprotocol IRprotocol_JVC PROGMEM;
+extern const IRprotocol IRprotocol_NECx PROGMEM;
+
+#ifdef IRLIB_VIEW_CAPTURE
+// Reads a capture slot in the receiver's units as microseconds. See IRLIB_VIEW_CAPTURE.
+class IRrawView
+{
+public:
+  volatile unsigned int *buf;    // Capture slot, or the buffer passed to UseExtnBuf
+  unsigned int tick;             // Microseconds per unit of buf
+  int excess;                    // Taken from marks and added to spaces
+  void set(volatile unsigned int *P, unsigned int Tick=1, int Excess=0) {buf=P; tick=Tick; excess=Excess;}
+  unsigned int operator[](irindex_t i) const {return buf[i]*tick + ((i % 2)? -excess: excess);}
+};
+#endif
+
 // Base class for decoding raw results
 class IRdecodeBase
 {
@@ -87,18 +200,29 @@ public:
   IRTYPES decode_type;           // NEC, SONY, RC5, UNKNOWN etc.
   unsigned long value;           // Decoded value
   unsigned char bits;            // Number of bits in decoded value
+#ifdef IRLIB_VIEW_CAPTURE
+  IRrawView rawbuf;              // Raw intervals in microseconds
+#else
   volatile unsigned int *rawbuf; // Raw intervals in microseconds
-  unsigned char rawlen;          // Number of records in rawbuf.
+#endif
+  irindex_t rawlen;              // Number of records in rawbuf.
   bool IgnoreHeader;             // Relaxed header detection allows AGC to settle
+  bool ExtnBuf;                  // Set by UseExtnBuf. Otherwise rawbuf is the receiver's buffer
+#ifdef IRLIB_ROLLING_HASH
+  bool HashReady;                // Set by GetResults if rawhash is the hash of rawbuf
+  unsigned long rawhash;         // Worked out by the receiver. See IRLIB_ROLLING_HASH
+#endif
   virtual void Reset(void);      // Initializes the decoder
   virtual bool decode(void);     // This base routine always returns false override with your routine
-  bool decodeGeneric(unsigned char Raw_Count, unsigned int Head_Mark, unsigned int Head_Space, 
+  bool decodeGeneric(irindex_t Raw_Count, unsigned int Head_Mark, unsigned int Head_Space, 
                      unsigned int Mark_One, unsigned int Mark_Zero, unsigned int Space_One, unsigned int Space_Zero);
+  bool decodeGeneric(const IRprotocol *Protocol); //Protocol must be in PROGMEM
   virtual void DumpResults (void);
   void UseExtnBuf(void *P); //Normally uses same rawbuf as IRrecv. Use this to define your own buffer.
   void copyBuf (IRdecodeBase *source);//copies rawbuf and rawlen from one decoder to another
+  unsigned int toPronto(char *Buf, unsigned int Max, unsigned char khz=38);//rawbuf as Pronto hex
 protected:
-  unsigned char offset;           // Index into rawbuf used various places
+  irindex_t offset;               // Index into rawbuf used various places
 };
 
 class IRdecodeHash: public virtual IRdecodeBase
@@ -110,6 +234,78 @@ protected:
   int compare(unsigned int oldval, unsigned int newval);//used by decodeHash
 };
 
+/*
+ * Maps received codes to actions of your own instead of a long chain of if statements.
+ * Each entry is a decode_type and value, or HASH_CODE and the hash from IRdecodeHash,
+ * with the number of the action. The table is kept in PROGMEM sorted by type and then
+ * by value, so IRfindAction needs a binary search of at most 9 steps for 500 buttons.
+ * extras/host/IRactions.cpp writes a sorted table from a list of buttons. If you write
+ * one yourself, IRcheckActions returns false if it isn't sorted or has a code twice.
+ */
+typedef struct {
+  IRTYPES Type;
+  unsigned long Value;
+  unsigned int Action;
+} IRaction;
+bool IRfindAction(const IRaction *Table, unsigned int Count, IRTYPES Type, unsigned long Value, unsigned int *Action);
+bool IRcheckActions(const IRaction *Table, unsigned int Count);
+
+/*
+ * Decodes frames too long for the 32 bit value, such as air conditioner codes which
+ * carry the whole state of the unit. The timing is an IRprotocol in PROGMEM. If its
+ * Num_Bits is zero any number of bits up to the size of payload is accepted. Bits are
+ * packed first bit received into the top of payload[0]. The value holds the last 32 bits
+ * as with decodeGeneric. The decode_type is left alone as with IRdecodeHash.
+ * RAWBUF must be raised to 2*bits+4 to capture such frames. IRLIB_PREDICT_END must stay
+ * off, since it would end a frame with the header of NEC after 32 bits.
+ */
+#define IRLIB_PAYLOAD_BYTES 32
+class IRdecodePayload: public virtual IRdecodeBase
+{
+public:
+  IRdecodePayload(const IRprotocol *Protocol);
+  unsigned char payload[IRLIB_PAYLOAD_BYTES];
+  unsigned int payload_bits;     // Number of bits in payload. bits stops at 255.
+  virtual void Reset(void);
+  virtual bool decode(void);
+  bool getBit(unsigned int n) {return payload[n/8] & (0x80>>(n%8));}
+protected:
+  const IRprotocol *Protocol;
+};
+
+/*
+ * Works out an IRprotocol for an unknown remote from its captures. The first mark and
+ * space are taken as the header, as decodeGeneric does. The other marks and spaces are
+ * gathered into clusters of lengths which MATCH each other, over every capture added, so
+ * add several different keys. If the marks fall into two clusters and the spaces into one
+ * the mark carries the data as with Sony. If it's the other way around the space does and
+ * the frame ends with a stop mark as with NEC. Num_Bits is only set if every capture had
+ * the same length. Phase coded protocols such as RC5 can't be described this way so
+ * analyze returns false for them. The carrier can't be seen in a capture so pass its kHz,
+ * perhaps measured with IRfrequency. DumpResults prints the clusters and the description
+ * ready to paste into a sketch. This replaces the averaging which IRanalyze did by hand.
+ */
+#define IRLIB_ANALYZE_CLUSTERS 4
+class IRanalyzer
+{
+public:
+  IRanalyzer(void) {Reset();};
+  void Reset(void);
+  bool add(IRdecodeBase *Capture);  // false if too short to be a frame of data
+  bool analyze(IRprotocol *Result, unsigned char kHz=38);
+  void DumpResults(unsigned char kHz=38);
+  unsigned int Captures;
+private:
+  typedef struct {unsigned long Sum; unsigned int Count;} cluster_t;
+  cluster_t Head_Mark, Head_Space, Marks[IRLIB_ANALYZE_CLUSTERS], Spaces[IRLIB_ANALYZE_CLUSTERS];
+  unsigned char Num_Marks, Num_Spaces;
+  unsigned int Others;              // intervals which fit no cluster
+  irindex_t Raw_Len;                // of every capture, or zero if they differ
+  static unsigned int mean(const cluster_t &C) {return C.Count? (C.Sum+C.Count/2)/C.Count: 0;};
+  static void put(cluster_t *C, unsigned char &Num, unsigned int &Others, unsigned int Time);
+  static unsigned char symbols(cluster_t *C, unsigned char Num, unsigned int &Total);
+};
+
 
 class IRdecodeNEC: public virtual IRdecodeBase 
 {
@@ -127,12 +323,14 @@ class IRdecodeRC: public virtual IRdecodeBase
 {
 public:
   enum RCLevel {MARK, SPACE, ERROR};//used by decoders for RC5/RC6
+  IRdecodeRC(void);
   // These are called by decode
   RCLevel getRClevel(unsigned char *used, const unsigned int t1);
 protected:
   unsigned char nbits;
   unsigned char used;
   long data;
+  unsigned int t1_Cached, t1_Low[3], t1_High[3];//MATCH limits for 1, 2 and 3 times t1
 };
 
 class IRdecodeRC5: public virtual IRdecodeRC 
@@ -177,7 +375,36 @@ public virtual IRdecodeNECx
 // , public virtual IRdecodeADDITIONAL //add additional protocols here
 {
 public:
-  virtual bool decode(void);    // Calls each decode routine individually
+  virtual bool decode(void);    // Calls each decode routine that could match
+protected:
+  unsigned char candidates(void); // Bit mask of decoders worth trying on this frame
+};
+
+/* Recognizes a frame while it is still arriving rather than after the gap which ends it.
+ * Intervals are fed one at a time and every protocol with a fixed structure is followed
+ * at once. A result is reported as soon as the last bit of NEC, NECx, Panasonic_Old or JVC
+ * arrives, at the NEC repeat header, or for Sony as soon as the space after a mark is too
+ * long to be followed by another bit. Use IRrecvBase::GetEarlyResults to feed it from a
+ * receiver. It can also be used like any other decoder after GetResults.
+ */
+#define IRSTREAM_PROTOCOLS 5
+class IRdecodeStream: public virtual IRdecodeBase
+{
+public:
+  IRdecodeStream(void);
+  virtual void Reset(void);
+  virtual bool decode(void);
+  bool feed(unsigned int Duration);      // Next interval in microseconds starting with the gap. True when recognized
+  bool feedSpace(unsigned long So_Far);  // Length so far of a space that has not ended yet
+  unsigned char Frame;                   // Used by GetEarlyResults to follow the receiver
+  irindex_t Fed;
+  bool Claimed;
+protected:
+  irindex_t Count;                       // Intervals fed in this frame
+  unsigned char Alive, Done;             // Bit masks of protocols still matching and of those complete
+  unsigned long Data[IRSTREAM_PROTOCOLS];
+  unsigned char Bit_Count[IRSTREAM_PROTOCOLS];
+  bool found(unsigned char Ended);
 };
 
 //Base class for sending signals
@@ -188,12 +415,30 @@ public:
   void sendGeneric(unsigned long data,  unsigned char Num_Bits, unsigned int Head_Mark, unsigned int Head_Space, 
                    unsigned int Mark_One, unsigned int Mark_Zero, unsigned int Space_One, unsigned int Space_Zero, 
 				   unsigned char kHz, bool Stop_Bits, unsigned long Max_Extent=0);
+  //Protocol must be in PROGMEM. Num_Bits of zero uses the protocol's own. Header false omits the header.
+  void sendGeneric(const IRprotocol *Protocol, unsigned long data, unsigned char Num_Bits=0, bool Header=true);
 protected:
   void enableIROut(unsigned char khz);
   VIRTUAL void mark(unsigned int usec);
   VIRTUAL void space(unsigned int usec);
   unsigned long Extent;
   unsigned char OnTime,OffTime,iLength;//used by bit-bang output.
+  unsigned int Periods_Scale;           //carrier cycles per microsecond times 65536, for AVR bit-bang
+  unsigned char Pin_Mask;
+  volatile uint8_t *Pin_Toggle;
+  void bitBang(unsigned int usec);
+  void bitBangConfig(unsigned char khz);
+  /* Between beginRecord and endRecord, marks and spaces are stored into Buf in IRsendRaw
+   * format instead of being sent. endRecord returns false if nothing was sent or it was
+   * longer than Max.
+   */
+  void beginRecord(unsigned int *Buf, irindex_t Max);
+  bool endRecord(void);
+  bool Recording, Rec_Over;
+  unsigned int *Rec_Buf, Rec_Last;
+  irindex_t Rec_Len, Rec_Max;
+  unsigned char Rec_kHz;
+  void store(unsigned int usec, bool Mark);
 };
 
 class IRsendNEC: public virtual IRsendBase
@@ -208,10 +453,51 @@ public:
   void send(unsigned long data, int nbits);
 };
 
+/* send_P plays a raw code straight from flash so a sketch can keep many learned codes
+ * without copying them into RAM. The code is a byte array in PROGMEM made by pack, for
+ * example by printing its bytes once and pasting them into the sketch. Its first byte is
+ * the frequency in kHz, then comes the number of intervals and then each interval as the
+ * difference from the one two before it, which is the previous mark or space. Numbers are
+ * stored 7 bits to a byte, low bits first, with the top bit set on all but the last byte.
+ * Differences are zigzag coded so that small ones of either sign take one byte. Marks and
+ * spaces of learned codes mostly differ from the previous one by a little jitter, so a
+ * code usually takes a little over a byte per interval instead of two.
+ * pack returns the number of bytes used or 0 if they don't fit in Max.
+ */
 class IRsendRaw: public virtual IRsendBase
 {
 public:
-  void send(unsigned int buf[], unsigned char len, unsigned char khz);
+  void send(unsigned int buf[], irindex_t len, unsigned char khz);
+  void send_P(const unsigned char *Code);
+  static unsigned int pack(const unsigned int *buf, irindex_t len, unsigned char khz,
+                           unsigned char *Code, unsigned int Max);
+  bool sendPronto(const char *Pronto);
+};
+
+/* Reads a learned Pronto code, the hex words that start with 0000, one interval at a time
+ * without copying it anywhere. The second word gives the carrier period in units of
+ * 0.241246us, the next two the number of mark/space pairs sent once and then while a key
+ * is held. The pairs follow in carrier cycles. A single press is taken to be the pairs
+ * sent once or, if there are none, the repeated ones. begin returns false if the code
+ * isn't a learned one or has more than 32767 pairs. Predefined codes such as 5000 for RC5, 6000 for RC6 and 900A for
+ * NEC hold a device and command rather than times. They are refused too and should be
+ * sent with IRsend using the protocol's own value. next returns false after the last interval or at a bad word.
+ * pack converts the rest of the code to the form IRsendRaw::send_P plays.
+ * IRsendRaw::sendPronto sends one straight from the string.
+ */
+class IRpronto
+{
+public:
+  bool begin(const char *Pronto);
+  bool next(unsigned int &usec);
+  unsigned int pack(unsigned char *Code, unsigned int Max);
+  unsigned char kHz;             // Carrier frequency rounded to kHz
+  unsigned int Len;              // Number of intervals in one press, not limited by RAWBUF
+private:
+  const char *P;
+  unsigned int Left;
+  unsigned long Cycle;           // Carrier period in 1/256us
+  bool word(unsigned int &W);
 };
 
 class IRsendRC5: public virtual IRsendBase
@@ -259,21 +545,88 @@ public:
   void send(IRTYPES Type, unsigned long data, unsigned int data2);
 };
 
+/* Sends on several IR LEDs which share the carrier from IR_SEND_PWM_PIN. Each emitter is wired
+ * so it only lights while the carrier is on and its own gate pin is HIGH, for example with a
+ * transistor driven from the gate pin switching its cathode. send with a mask of emitters
+ * transmits one frame on all of them at once. load records a frame for a single emitter into
+ * the buffer given to addEmitter and sendLoaded then transmits every loaded frame together,
+ * taking the time of the longest one rather than the sum of them. Frames sent together share
+ * one carrier frequency, that of the first frame loaded.
+ */
+#define IRLIB_MAX_EMITTERS 4
+class IRsendMulti: public IRsend
+{
+public:
+  IRsendMulti(void);
+  //Returns false if there are already IRLIB_MAX_EMITTERS. Buf is only needed for load.
+  bool addEmitter(unsigned char GatePin, unsigned int *Buf=NULL, irindex_t Size=0);
+  using IRsend::send;
+  void send(unsigned char Mask, IRTYPES Type, unsigned long data, unsigned int data2);
+  //Returns false if the frame does not fit the emitter's buffer
+  bool load(unsigned char Emitter, IRTYPES Type, unsigned long data, unsigned int data2);
+  void sendLoaded(void);
+private:
+  struct {unsigned char Pin; unsigned int *Buf; irindex_t Size, Len;} Emitters[IRLIB_MAX_EMITTERS];
+  unsigned char Count, Loaded_kHz;
+};
+
+#ifdef USE_IRSEND_ASYNC
+/* Sends without waiting. send records the frame into one of IRLIB_SEND_SLOTS buffers and
+ * returns at once, or returns false if they are all waiting to go out. The overflow interrupt
+ * of the sending timer comes once per carrier cycle. It counts the cycles of each mark and
+ * space and switches the carrier between them. isBusy is true until every queued frame has
+ * gone. A function given to onDone is called from the interrupt after each frame.
+ * IRrecv usually shares the timer, so wait until isBusy is false before calling enableIRIn.
+ * If the timer has no interrupt to spare, as with bit-bang output, send waits as IRsend does.
+ */
+#define IRLIB_SEND_SLOTS 2       //power of two
+#define IRLIB_SEND_SLOT_LEN 128  //intervals. Sony sends three frames of 42 at a time.
+class IRsendAsync: public IRsend
+{
+public:
+  IRsendAsync(void);
+  bool send(IRTYPES Type, unsigned long data, unsigned int data2);
+  bool isBusy(void) {return Busy;};
+  void onDone(void (*Callback)(void)) {Done=Callback;};
+  void nextCycle(void); //only for the interrupt
+private:
+  void start(void);
+  unsigned int Slots[IRLIB_SEND_SLOTS][IRLIB_SEND_SLOT_LEN]; //carrier cycles of each interval
+  irindex_t Lens[IRLIB_SEND_SLOTS];
+  unsigned char kHz[IRLIB_SEND_SLOTS];
+  volatile unsigned char head, tail; //written only by send and only by the interrupt
+  volatile bool Busy;
+  irindex_t Index;
+  unsigned int Left;
+  void (*Done)(void);
+};
+#endif
+
 // Changed this to a base class so it can be extended
+/* Each receiver records into an irparams_t. Unless you pass one to the constructor it
+ * uses the global irparams, so only one receiver at a time can use that. To run several,
+ * give the others an irparams_t each and raise IRLIB_MAX_RECEIVERS.
+ */
+struct irparams_t;
 class IRrecvBase
 {
 public:
-  IRrecvBase(void) {};
-  IRrecvBase(unsigned char recvpin);
+  IRrecvBase(void);
+  IRrecvBase(unsigned char recvpin, volatile irparams_t *State=NULL);
   void No_Output(void);
   void blink13(bool blinkflag);
   bool GetResults(IRdecodeBase *decoder, const unsigned int Time_per_Ticks=1);
+  //Feeds the frame being received to the decoder. Returns true when it is recognized or has ended.
+  bool GetEarlyResults(IRdecodeStream *decoder, const unsigned int Time_per_Ticks=1);
   void enableIRIn(void);
   virtual void resume(void);
   unsigned char getPinNum(void);
+  unsigned char getDroppedFrames(void); //frames lost because every buffer was full. Wraps at 255.
+  unsigned char getOverflows(void);     //frames cut short at RAWBUF. Wraps at 255.
   unsigned char Mark_Excess;
 protected:
   void Init(void);
+  volatile irparams_t *params;  //state of this receiver
 };
 
 /* Original IRrecv class uses 50s interrupts to sample input. While this is generally
@@ -286,11 +639,34 @@ protected:
 class IRrecv: public IRrecvBase
 {
 public:
-  IRrecv(unsigned char recvpin):IRrecvBase(recvpin){};
+  IRrecv(unsigned char recvpin, volatile irparams_t *State=NULL):IRrecvBase(recvpin,State){};
   bool GetResults(IRdecodeBase *decoder);
-  void enableIRIn(void);
-  void resume(void);
+  bool GetEarlyResults(IRdecodeStream *decoder);
+  //Returns false if IRLIB_MAX_RECEIVERS others are enabled. This one is then never sampled.
+  bool enableIRIn(void);
+#ifdef IRLIB_ISR_STATS
+  //Shortest, average and longest interrupt in CPU cycles since enableIRIn or the last call
+  void getISRCycles(unsigned int *Min, unsigned int *Avg, unsigned int *Max);
+#endif
 };
+
+/* Samples the input exactly like IRrecv but only while a frame is arriving. Once the line
+ * has been quiet for a gap the 50us timer interrupt is switched off. The first mark of the
+ * next frame switches it back on through an external interrupt, so the results are the same
+ * as IRrecv's while an idle receiver takes no processor time at all. Pass the interrupt
+ * number as with IRrecvPCI. Needs USE_ATTACH_INTERRUPTS.
+ */
+#ifdef USE_ATTACH_INTERRUPTS
+class IRrecvHybrid: public IRrecv
+{
+public:
+  //Note this is interrupt number not pin number
+  IRrecvHybrid(unsigned char inum, volatile irparams_t *State=NULL);
+  bool enableIRIn(void);
+private:
+  unsigned char intrnum;
+};
+#endif
 #endif
 /* This receiver uses no interrupts or timers. Other interrupt driven receivers
  * allow you to do other things and call GetResults at your leisure to see if perhaps
@@ -304,7 +680,7 @@ public:
 class IRrecvLoop: public IRrecvBase
 {
 public:
-  IRrecvLoop(unsigned char recvpin):IRrecvBase(recvpin){};
+  IRrecvLoop(unsigned char recvpin, volatile irparams_t *State=NULL):IRrecvBase(recvpin,State){};
   bool GetResults(IRdecodeBase *decoder);
 };
 
@@ -323,11 +699,15 @@ class IRrecvPCI: public IRrecvBase
 {
 public:
   //Note this is interrupt number not pin number
-  IRrecvPCI(unsigned char inum);
+  IRrecvPCI(unsigned char inum, volatile irparams_t *State=NULL);
   bool GetResults(IRdecodeBase *decoder);
+  bool GetEarlyResults(IRdecodeStream *decoder);
+  //Returns false if IRLIB_MAX_RECEIVERS others have taken every handler. This one is then never called.
+  bool enableIRIn(void);
   void resume(void);
 private:
   unsigned char intrnum;
+  unsigned char slot;   //which handler it was given, 0xff if none yet
 };
 
 /* This class facilitates detection of frequency of an IR signal. Requires a TSMP58000
@@ -361,8 +741,14 @@ private:
 
 //Do the actual blinking off and on
 //This is not part of IRrecvBase because it may need to be inside an ISR
-//and we cannot pass parameters to them.
+//and we cannot pass parameters to them. Without a parameter it uses irparams.
+void do_Blink(volatile irparams_t &Rcv);
 void do_Blink(void);
+//Called by a receiver when the frame it is recording is complete. Moves on to a free buffer
+//and returns true, or returns false and stops if every buffer holds a frame not yet resumed.
+bool do_FrameDone(volatile irparams_t &Rcv);
+//Called by a receiver when rawlen reaches 3. Sets expected and endspace from the header.
+void do_Predict(volatile irparams_t &Rcv, const unsigned int Time_per_Tick);
 
 /* This routine maps interrupt numbers used by attachInterrupt() into pin numbers.
  * NOTE: these interrupt numbers which are passed to attachInterrupt() are not 
@@ -56,17 +56,47 @@
  * is controlled by the IRLIB_USE_PERCENT definition a few lines above.
  */
  
-#define PERCENT_LOW(us) (unsigned int) (((us)*(1.0 - PERCENT_TOLERANCE/100.)))
-#define PERCENT_HIGH(us) (unsigned int) (((us)*(1.0 + PERCENT_TOLERANCE/100.) + 1))
+/*
+ * The percentage limits use integer arithmetic only. Earlier versions multiplied by a double
+ * which pulled floating point into every comparison. When the expected value is a constant
+ * such as MATCH(rawbuf[1],4500) the compiler computes the limits and the test is just two
+ * integer compares.
+ */
+#define PERCENT_LOW(us) (unsigned int) (((unsigned long)(us)*(100 - PERCENT_TOLERANCE))/100)
+#define PERCENT_HIGH(us) (unsigned int) (((unsigned long)(us)*(100 + PERCENT_TOLERANCE))/100 + 1)
 
 #define ABS_MATCH(v,e,t) ((v) >= ((e)-(t)) && (v) <= ((e)+(t)))
 #define PERC_MATCH(v,e) ((v) >= PERCENT_LOW(e) && (v) <= PERCENT_HIGH(e))
 
 #ifdef IRLIB_USE_PERCENT
 #define MATCH(v,e) PERC_MATCH(v,e)
+#define MATCH_LOW(e) PERCENT_LOW(e)
+#define MATCH_HIGH(e) PERCENT_HIGH(e)
 #else
 #define MATCH(v,e) ABS_MATCH(v,e,DEFAULT_ABS_TOLERANCE)
+#define MATCH_LOW(e) ((e)-DEFAULT_ABS_TOLERANCE)
+#define MATCH_HIGH(e) ((e)+DEFAULT_ABS_TOLERANCE)
 #endif
+/*
+ * If the expected value is a variable, as it is in decodeGeneric, MATCH has to compute the
+ * limits again for every comparison. Instead compute them once into an IRmatchWindow and
+ * compare against that. The limits are the same ones that MATCH uses. For example
+ *   IRmatchWindow One(Mark_One);
+ *   while(...) {if (One.match(rawbuf[offset])) ...}
+ * For a constant, IRmatchConst<4500>::Low and IRmatchConst<4500>::High are compile time values.
+ */
+class IRmatchWindow {
+public:
+  IRmatchWindow(void) {Low=1; High=0;};//matches nothing until set
+  IRmatchWindow(unsigned int Expected) {set(Expected);};
+  void set(unsigned int Expected) {Low=MATCH_LOW(Expected); High=MATCH_HIGH(Expected);};
+  bool match(unsigned int Value) const {return Value >= Low && Value <= High;};
+  unsigned int Low, High;
+};
+template <unsigned int Expected> struct IRmatchConst {
+  enum {Low=MATCH_LOW(Expected), High=MATCH_HIGH(Expected)};
+  static bool match(unsigned int Value) {return Value >= (unsigned int)Low && Value <= (unsigned int)High;};
+};
 
 //The following two routines are no longer necessary because mark/space adjustments are done elsewhere
 //These definitions maintain backward compatibility.
@@ -77,7 +107,7 @@
 void IRLIB_ATTEMPT_MESSAGE(const __FlashStringHelper * s);
 void IRLIB_TRACE_MESSAGE(const __FlashStringHelper * s);
 byte IRLIB_REJECTION_MESSAGE(const __FlashStringHelper * s);
-byte IRLIB_DATA_ERROR_MESSAGE(const __FlashStringHelper * s, unsigned char index, unsigned int value, unsigned int expected);
+byte IRLIB_DATA_ERROR_MESSAGE(const __FlashStringHelper * s, irindex_t index, unsigned int value, unsigned int expected);
 #define RAW_COUNT_ERROR IRLIB_REJECTION_MESSAGE(F("number of raw samples"));
 #define HEADER_MARK_ERROR(expected) IRLIB_DATA_ERROR_MESSAGE(F("header mark"),offset,rawbuf[offset],expected);
 #define HEADER_SPACE_ERROR(expected) IRLIB_DATA_ERROR_MESSAGE(F("header space"),offset,rawbuf[offset],expected);
@@ -33,21 +33,69 @@
 /*
  * The structure contains a variety of variables needed by the receiver routines.
  * Typically this data would be part of the IRrecv class however the interrupt service routine
- * must have access to it and you cannot pass a parameter to such a routine. The data must be global.
+ * must have access to it and you cannot pass a parameter to such a routine. The global irparams is
+ * used by any receiver that isn't given its own. Each further receiver needs its own irparams_t,
+ * which must be global or static, passed to its constructor. See IRLIB_MAX_RECEIVERS in IRLib.h.
  * You need not include this file unless you are creating a custom receiver class or extending
  * the provided IRrecv class.
+ * Frames are recorded into a ring of IRLIB_CAPTURE_SLOTS buffers. The receiver writes through
+ * rawbuf into slot head % IRLIB_CAPTURE_SLOTS and calls do_FrameDone when the frame ends.
+ * GetResults hands over slot tail % IRLIB_CAPTURE_SLOTS and resume releases it. 
+ * This is a single producer, single consumer queue. The receiver's interrupt code is the
+ * only writer of head and the sketch (GetResults and resume) is the only writer of tail
+ * and ended, so neither side needs to turn interrupts off. All three are single bytes
+ * which the processor reads and writes in one go.
  */
+#if (IRLIB_CAPTURE_SLOTS & (IRLIB_CAPTURE_SLOTS-1)) || IRLIB_CAPTURE_SLOTS>128
+#error IRLIB_CAPTURE_SLOTS must be a power of two no more than 128 so that the counts wrap cleanly
+#endif
+#if IRLIB_MAX_RECEIVERS<1 || IRLIB_MAX_RECEIVERS>8
+#error IRLIB_MAX_RECEIVERS must be from 1 to 8
+#endif
+#if defined(IRLIB_VIEW_CAPTURE) && defined(IRLIB_COMPACT_CAPTURE)
+#error IRLIB_VIEW_CAPTURE reads the slots in place so it cannot be used with IRLIB_COMPACT_CAPTURE
+#endif
+
+/* Recorded intervals. See IRLIB_COMPACT_CAPTURE in IRLib.h. A byte holding IRLIB_SAMPLE_ESCAPE
+ * is longer than a byte can hold. For the gap at index 0 the full value is in slotgap.
+ */
+#ifdef IRLIB_COMPACT_CAPTURE
+typedef unsigned char irsample_t;
+#define IRLIB_SAMPLE_ESCAPE 255
+#define USECPERSAMPLE 64  //microseconds per unit recorded by IRrecvPCI and IRrecvLoop
+#else
+typedef unsigned int irsample_t;
+#define USECPERSAMPLE 1
+#endif
 
 // receiver states
 enum rcvstate_t {STATE_UNKNOWN, STATE_IDLE, STATE_MARK, STATE_SPACE, STATE_STOP, STATE_RUNNING};
 // information for the interrupt handler
-typedef struct {
+typedef struct irparams_t {
   unsigned char recvpin;    // pin for IR data from detector
   rcvstate_t rcvstate;       // state machine
   bool blinkflag;         // TRUE to enable blinking of pin 13 on IR processing
   unsigned long timer;     // state timer, counts 50uS ticks.(and other uses)
-  unsigned int rawbuf[RAWBUF]; // raw data
-  unsigned char rawlen;         // counter of entries in rawbuf
+  irsample_t *rawbuf;           // raw data of the frame being recorded, one of the slots
+  irindex_t rawlen;             // counter of entries in rawbuf
+  irsample_t slots[IRLIB_CAPTURE_SLOTS][RAWBUF]; // completed frames and the one being recorded
+#ifdef IRLIB_COMPACT_CAPTURE
+  unsigned int slotgap[IRLIB_CAPTURE_SLOTS];      // gap before each frame
+  unsigned int view[RAWBUF];    // microseconds of the frame handed over, shared by decoders
+#endif
+  irindex_t slotlen[IRLIB_CAPTURE_SLOTS];          // rawlen of each completed frame
+  unsigned char head, tail;     // counts of frames completed and frames resumed. Slot is count % IRLIB_CAPTURE_SLOTS
+  unsigned char ended;          // equals head if GetResults saw the frame end before the receiver did
+  unsigned char dropped;        // frames which started while every slot was full
+  unsigned char overflows;      // frames cut short because they were longer than RAWBUF
+  irindex_t expected;           // rawlen which completes the frame being recorded, 0 if unknown
+  unsigned int endspace;        // length of space in ticks which ends it without a gap, 0 if none
+#ifdef IRLIB_ROLLING_HASH
+  unsigned long hash;           // IRdecodeHash of the frame being recorded so far
+  unsigned long slothash[IRLIB_CAPTURE_SLOTS];     // hash of each completed frame
+  unsigned int hashtick;        // microseconds per unit and Mark_Excess that the hash
+  unsigned char hashexcess;     // converts intervals with, set by enableIRIn
+#endif
 } 
 irparams_t;
 extern volatile irparams_t irparams;
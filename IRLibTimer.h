@@ -102,13 +102,22 @@
  * NOTE: By un-commenting this line, you are forcing the library to ignore
  * hardware detection and timer specifications above. The bit-bang frequency
  * code is not as accurate as using a hardware timer but it is more flexible and 
- * less hardware platform dependent.
+ * less hardware platform dependent. On AVR it counts CPU cycles so only interrupts
+ * which come during a mark spoil it. See the IRbitbang example to measure it.
  */
 //#define IR_SEND_BIT_BANG  3  //Be sure to set this pin number if you un-comment
 
 /* This is a fudge factor that adjusts bit-bang timing. Feel free to experiment
- * for best results.*/
+ * for best results. It is only used on boards other than AVR.*/
 #define IR_BIT_BANG_OVERHEAD 10
+/* On AVR the bit-bang carrier comes from a loop in which every instruction takes a known
+ * number of CPU cycles. See IRsendBase::bitBang. The high part of each carrier cycle lasts
+ * 3*ON+2 cycles and the low part 3*OFF+6. These work out ON and OFF so that a third of
+ * each cycle is high, as with the hardware timers, at the frequency asked for.
+ */
+#define IR_BIT_BANG_CYCLES(khz)    ((F_CPU/1000+(khz)/2)/(khz))
+#define IR_BIT_BANG_ON_LOOPS(khz)  ((IR_BIT_BANG_CYCLES(khz)/3-2+1)/3)
+#define IR_BIT_BANG_OFF_LOOPS(khz) ((IR_BIT_BANG_CYCLES(khz)-3*IR_BIT_BANG_ON_LOOPS(khz)-8+1)/3)
 
 /* We are going to presume that you want to use the same hardware timer to control
  * the 50 microsecond interrupt used by the IRrecv receiver class as was specified
@@ -156,20 +165,30 @@
 
 #if defined(IR_SEND_BIT_BANG)  //defines for bit-bang output
 	#define IR_SEND_PWM_PIN	IR_SEND_BIT_BANG
-	#define IR_SEND_PWM_START   unsigned int jmax=time/iLength;\
-		for(unsigned int j=0;j<jmax;j++) {\
-		  digitalWrite(IR_SEND_BIT_BANG, HIGH);  delayMicroseconds(OnTime);\
-		  digitalWrite(IR_SEND_BIT_BANG, LOW);   delayMicroseconds(OffTime);}
-	#define IR_SEND_MARK_TIME(time) 
-	#define IR_SEND_PWM_STOP
-	#define IR_SEND_CONFIG_KHZ(val)  float Length=1000.0/(float)khz;\
-		iLength=int(Length+0.5); OnTime=int(Length/3.0); \
-		OffTime=iLength-OnTime-IR_BIT_BANG_OVERHEAD-(val<40);
+	#if defined(__AVR__)
+		#define IR_SEND_PWM_START   bitBang(time)
+		#define IR_SEND_MARK_TIME(time) 
+		#define IR_SEND_PWM_STOP
+		#define IR_SEND_CONFIG_KHZ(val)  bitBangConfig(val)
+	#else
+		#define IR_SEND_PWM_START   unsigned int jmax=time/iLength;\
+			for(unsigned int j=0;j<jmax;j++) {\
+			  digitalWrite(IR_SEND_BIT_BANG, HIGH);  delayMicroseconds(OnTime);\
+			  digitalWrite(IR_SEND_BIT_BANG, LOW);   delayMicroseconds(OffTime);}
+		#define IR_SEND_MARK_TIME(time) 
+		#define IR_SEND_PWM_STOP
+		#define IR_SEND_CONFIG_KHZ(val)  float Length=1000.0/(float)khz;\
+			iLength=int(Length+0.5); OnTime=int(Length/3.0); \
+			OffTime=iLength-OnTime-IR_BIT_BANG_OVERHEAD-(val<40);
+	#endif
 
 #elif defined(IR_SEND_TIMER1) // defines for timer1 (16 bits)
 	#define IR_SEND_PWM_START     (TCCR1A |= _BV(COM1A1))
 	#define IR_SEND_MARK_TIME(time)  My_delay_uSecs(time)
 	#define IR_SEND_PWM_STOP    (TCCR1A &= ~(_BV(COM1A1)))
+	#define IR_SEND_INTR_ENABLE   (TIMSK1 = _BV(TOIE1))
+	#define IR_SEND_INTR_DISABLE  (TIMSK1 = 0)
+	#define IR_SEND_INTR_NAME     TIMER1_OVF_vect
 	#define IR_SEND_CONFIG_KHZ(val) ({ \
 		const uint16_t pwmval = SYSCLOCK / 2000 / (val); \
 		TCCR1A = _BV(WGM11); TCCR1B = _BV(WGM13) | _BV(CS10); \
@@ -184,6 +203,9 @@
 	#define IR_SEND_PWM_START     (TCCR2A |= _BV(COM2B1))
 	#define IR_SEND_MARK_TIME(time)  My_delay_uSecs(time)
 	#define IR_SEND_PWM_STOP    (TCCR2A &= ~(_BV(COM2B1)))
+	#define IR_SEND_INTR_ENABLE   (TIMSK2 = _BV(TOIE2))
+	#define IR_SEND_INTR_DISABLE  (TIMSK2 = 0)
+	#define IR_SEND_INTR_NAME     TIMER2_OVF_vect
 	#define IR_SEND_CONFIG_KHZ(val) ({ \
 		const uint8_t pwmval = SYSCLOCK / 2000 / (val); \
 		TCCR2A = _BV(WGM20);  TCCR2B = _BV(WGM22) | _BV(CS20); \
@@ -198,6 +220,9 @@
 	#define IR_SEND_PWM_START     (TCCR3A |= _BV(COM3A1))
 	#define IR_SEND_MARK_TIME(time)  My_delay_uSecs(time)
 	#define IR_SEND_PWM_STOP    (TCCR3A &= ~(_BV(COM3A1)))
+	#define IR_SEND_INTR_ENABLE   (TIMSK3 = _BV(TOIE3))
+	#define IR_SEND_INTR_DISABLE  (TIMSK3 = 0)
+	#define IR_SEND_INTR_NAME     TIMER3_OVF_vect
 	#define IR_SEND_CONFIG_KHZ(val) ({ \
 		const uint16_t pwmval = SYSCLOCK / 2000 / (val); \
 		TCCR3A = _BV(WGM31);   TCCR3B = _BV(WGM33) | _BV(CS30); \
@@ -212,6 +237,11 @@
 	#define IR_SEND_PWM_START     (TCCR4A |= _BV(COM4A1))
 	#define IR_SEND_MARK_TIME(time)  My_delay_uSecs(time)
 	#define IR_SEND_PWM_STOP    (TCCR4A &= ~(_BV(COM4A1)))
+	#if !defined(IR_RECV_TIMER4_HS) // IRrecv already uses this vector
+		#define IR_SEND_INTR_ENABLE   (TIMSK4 = _BV(TOIE4))
+		#define IR_SEND_INTR_DISABLE  (TIMSK4 = 0)
+		#define IR_SEND_INTR_NAME     TIMER4_OVF_vect
+	#endif
 	#define IR_SEND_CONFIG_KHZ(val) ({ \
 		const uint16_t pwmval = SYSCLOCK / 2000 / (val); \
 		TCCR4A = (1<<PWM4A);   TCCR4B = _BV(CS40); \
@@ -228,6 +258,9 @@
 	#define IR_SEND_PWM_START     (TCCR4A |= _BV(COM4A1))
 	#define IR_SEND_MARK_TIME(time)  My_delay_uSecs(time)
 	#define IR_SEND_PWM_STOP    (TCCR4A &= ~(_BV(COM4A1)))
+	#define IR_SEND_INTR_ENABLE   (TIMSK4 = _BV(TOIE4))
+	#define IR_SEND_INTR_DISABLE  (TIMSK4 = 0)
+	#define IR_SEND_INTR_NAME     TIMER4_OVF_vect
 	#define IR_SEND_CONFIG_KHZ(val) ({ \
 		const uint16_t pwmval = SYSCLOCK / 2000 / (val); \
 		TCCR4A = _BV(WGM41); TCCR4B = _BV(WGM43) | _BV(CS40); \
@@ -242,6 +275,9 @@
 	#define IR_SEND_PWM_START     (TCCR5A |= _BV(COM5A1))
 	#define IR_SEND_MARK_TIME(time)  My_delay_uSecs(time)
 	#define IR_SEND_PWM_STOP    (TCCR5A &= ~(_BV(COM5A1)))
+	#define IR_SEND_INTR_ENABLE   (TIMSK5 = _BV(TOIE5))
+	#define IR_SEND_INTR_DISABLE  (TIMSK5 = 0)
+	#define IR_SEND_INTR_NAME     TIMER5_OVF_vect
 	#define IR_SEND_CONFIG_KHZ(val) ({ \
 		const uint16_t pwmval = SYSCLOCK / 2000 / (val); \
 		TCCR5A = _BV(WGM51);   TCCR5B = _BV(WGM53) | _BV(CS50); \
@@ -267,6 +303,8 @@
 	#define IR_RECV_CONFIG_TICKS() ({ \
 		TCCR1A = 0;   TCCR1B = _BV(WGM12) | _BV(CS10); \
 		OCR1A = SYSCLOCK * USECPERTICK / 1000000;   TCNT1 = 0; })
+	#define IR_RECV_TIMER_COUNT()  TCNT1
+	#define IR_RECV_CYCLES_PER_COUNT 1
 
 #elif defined(IR_RECV_TIMER2)  // defines for timer2 (8 bits)
 	#define IR_RECV_ENABLE_INTR    (TIMSK2 = _BV(OCIE2A))
@@ -277,11 +315,14 @@
 		#define IR_RECV_CONFIG_TICKS() ({ \
 			TCCR2A = _BV(WGM21);  TCCR2B = _BV(CS20); \
 			OCR2A = IR_RECV_COUNT_TOP;   TCNT2 = 0; })
+		#define IR_RECV_CYCLES_PER_COUNT 1
 	#else
 		#define IR_RECV_CONFIG_TICKS() ({ \
 			TCCR2A = _BV(WGM21);   TCCR2B = _BV(CS21); \
 			OCR2A = IR_RECV_COUNT_TOP / 8;   TCNT2 = 0; })
+		#define IR_RECV_CYCLES_PER_COUNT 8
 	#endif
+	#define IR_RECV_TIMER_COUNT()  TCNT2
 
 #elif defined(IR_RECV_TIMER3)  // defines for timer3 (16 bits)
 	#define IR_RECV_ENABLE_INTR    (TIMSK3 = _BV(OCIE3A))
@@ -290,6 +331,8 @@
 	#define IR_RECV_CONFIG_TICKS() ({ \
 		TCCR3A = 0;   TCCR3B = _BV(WGM32) | _BV(CS30); \
 		OCR3A = SYSCLOCK * USECPERTICK / 1000000;   TCNT3 = 0; })
+	#define IR_RECV_TIMER_COUNT()  TCNT3
+	#define IR_RECV_CYCLES_PER_COUNT 1
 
 #elif defined(IR_RECV_TIMER4_HS)  // defines for timer4 (10 bits, high speed option)
 	#define IR_RECV_ENABLE_INTR    (TIMSK4 = _BV(TOIE4))
@@ -301,6 +344,10 @@
 		TC4H = (SYSCLOCK * USECPERTICK / 1000000) >> 8; \
 		OCR4C = (SYSCLOCK * USECPERTICK / 1000000) & 255; \
 		TC4H = 0;   TCNT4 = 0; })
+	#define IR_RECV_TIMER_COUNT()  ({ \
+		unsigned int Low = TCNT4; /* reading TCNT4 latches the high bits into TC4H */ \
+		Low | ((unsigned int)TC4H << 8); })
+	#define IR_RECV_CYCLES_PER_COUNT 1
 
 #elif defined(IR_RECV_TIMER4) // defines for timer4 (16 bits)
 	#define IR_RECV_ENABLE_INTR    (TIMSK4 = _BV(OCIE4A))
@@ -309,6 +356,8 @@
 	#define IR_RECV_CONFIG_TICKS() ({ \
 		TCCR4A = 0;   TCCR4B = _BV(WGM42) | _BV(CS40); \
 		OCR4A = SYSCLOCK * USECPERTICK / 1000000;   TCNT4 = 0; })
+	#define IR_RECV_TIMER_COUNT()  TCNT4
+	#define IR_RECV_CYCLES_PER_COUNT 1
 
 #elif defined(IR_RECV_TIMER5)  // defines for timer5 (16 bits)
 	#define IR_RECV_ENABLE_INTR    (TIMSK5 = _BV(OCIE5A))
@@ -317,10 +366,26 @@
 	#define IR_RECV_CONFIG_TICKS() ({ \
 		TCCR5A = 0;   TCCR5B = _BV(WGM52) | _BV(CS50); \
 		OCR5A = SYSCLOCK * USECPERTICK / 1000000;   TCNT5 = 0; })
+	#define IR_RECV_TIMER_COUNT()  TCNT5
+	#define IR_RECV_CYCLES_PER_COUNT 1
 #else // unknown timer
 	#error "Internal code configuration error, no known IR_RECV_TIMER# defined\n"
 #endif
 
+/* The IRrecv interrupt reads the input pin 20,000 times a second. Where the core maps
+ * pins to port registers, enableIRIn looks up the port and bit of the pin once and the
+ * interrupt reads the register itself, which is far quicker than digitalRead. Ports are
+ * 8 bits on AVR and taken to be 32 bits elsewhere, as on the Due and Teensy 3.
+ */
+#if defined(portInputRegister)
+	#define IR_RECV_READ_PORT
+	#if defined(__AVR__)
+		typedef uint8_t irport_t;
+	#else
+		typedef uint32_t irport_t;
+	#endif
+#endif
+
 // defines for blinking the LED
 #if defined(CORE_LED0_PIN)
 #define BLINKLED       CORE_LED0_PIN
@@ -31,6 +31,12 @@ public:
 
 #define GICABLE (LAST_PROTOCOL+1)
 
+/* Because this protocol fits the generic send and decode routines, its timing can be
+ * described once in flash and used in both directions. The fields are
+ * Head_Mark, Head_Space, Mark_One, Mark_Zero, Space_One, Space_Zero, Max_Extent, kHz, Num_Bits, Use_Stop
+ */
+const IRprotocol IRprotocol_GIcable PROGMEM= {490*18, 490*9, 490, 490, 490*9, 2205/*(4.5*490)*/, 0, 39, 16, true};
+
 /* The IRP notation for this protocol according to
  * http://www.hifi-remote.com/johnsfine/DecodeIR.html#G.I. Cable
  * is "{38.7k,490}<1,-4.5|1,-9>(18,-9,F:8,D:4,C:4,1,-84,(18,-4.5,1,-178)*) {C = -(D + F:4 + F:4:4)}"
@@ -44,7 +50,7 @@ bool IRdecodeGIcable::decode(void) {
     decode_type= static_cast<IRTYPES>GICABLE;
     return true;
   }
-  if(!decodeGeneric(36, 18*490, 9*490, 0, 490, 9*490, 2205/*(4.5*490)*/)) return false;
+  if(!decodeGeneric(&IRprotocol_GIcable)) return false;
   decode_type= static_cast<IRTYPES>GICABLE;
   return true;
 };
@@ -54,7 +60,7 @@ void IRsendGIcable::send(unsigned long data, bool Repeat) {
     enableIROut(39);
     mark (490*18); space (2205); mark (490); space(220);delay (87);//actually "space(87200);"
   } else {
-    sendGeneric(data,16, 490*18, 490*9, 490, 490, 490*9, 2205, 39, true);
+    sendGeneric(&IRprotocol_GIcable, data);
   }
 };
 
@@ -0,0 +1,63 @@
+/* Example program for from IRLib – an Arduino library for infrared encoding and decoding
+ * Version 1.6   (in development)
+ * Copyright 2014 by Chris Young http://cyborg5.com
+ */
+/*
+ * IRactions: look up what a button does in a table kept in flash
+ * Codes that decode are found by protocol and value. Anything else is found by its hash
+ * as IRhashdecode prints it. The table below was written by extras/host/IRactions from
+ * a list of buttons, which sorts it so that IRfindAction can use a binary search. It
+ * takes no RAM and about as long to search with hundreds of buttons as with a few.
+ */
+
+#include <IRLib.h>
+
+int RECV_PIN = 11;
+
+IRrecv My_Receiver(RECV_PIN);
+IRdecode My_Decoder;
+IRdecodeHash My_Hash_Decoder;
+
+//Written by extras/host/IRactions. Look codes up with IRfindAction.
+enum {Power, Volume_Up, Volume_Down, Mute};
+const IRaction My_Actions[] PROGMEM={
+  {NEC, 0x61a030cf, Volume_Up},
+  {NEC, 0x61a0b04f, Volume_Down},
+  {NEC, 0x61a0f00f, Power},
+  {SONY, 0x290, Mute},
+  {SONY, 0x490, Volume_Up},
+  {SONY, 0xa90, Power},
+  {SONY, 0xc90, Volume_Down},
+  {HASH_CODE, 0x9d7e0c4b, Mute}
+};
+#define ACTIONS (sizeof(My_Actions)/sizeof(My_Actions[0]))
+
+void setup()
+{
+  Serial.begin(9600);
+  delay(2000);while(!Serial);//delay for Leonardo
+  if(!IRcheckActions(My_Actions,ACTIONS)) Serial.println(F("My_Actions is not sorted"));
+  My_Receiver.enableIRIn(); // Start the receiver
+}
+
+void loop() {
+  if (My_Receiver.GetResults(&My_Decoder)) {
+    My_Hash_Decoder.copyBuf(&My_Decoder);
+    unsigned int Action;
+    bool Found;
+    if (My_Decoder.decode()) {
+      Found=IRfindAction(My_Actions,ACTIONS,My_Decoder.decode_type,My_Decoder.value,&Action);
+    } else {
+      My_Hash_Decoder.decode();
+      Found=IRfindAction(My_Actions,ACTIONS,HASH_CODE,My_Hash_Decoder.hash,&Action);
+    }
+    if (!Found) Serial.println(F("Unknown button"));
+    else switch(Action) {
+      case Power:       Serial.println(F("Power")); break;
+      case Volume_Up:   Serial.println(F("Volume up")); break;
+      case Volume_Down: Serial.println(F("Volume down")); break;
+      case Mute:        Serial.println(F("Mute")); break;
+    }
+    My_Receiver.resume();
+  }
+}
@@ -9,6 +9,9 @@
 /* IRanalyze receives repeated values from a remote and averages the results. Should help in
  * analyzing unknown protocols. You have to press the same key repeatedly. If you press a 
  * different key the totals reset and it computes new averages.
+ * Every capture is also given to an IRanalyzer which keeps going across keys. After a few
+ * different keys it prints an IRprotocol description you can paste into your sketch and
+ * pass to sendGeneric and decodeGeneric. Set kHz if you know the frequency.
  */
 #include <IRLib.h>
 #include <IRLibRData.h>
@@ -25,8 +28,12 @@ IRrecv     My_Receiver(RECV_PIN);
 //IRrecvLoop My_Receiver(RECV_PIN);
 //Use interrupt=0. This is pin 2 on Arduino Uno and Mega, pin 3 on Leonardo
 //IRrecvPCI  My_Receiver(0);
+//Samples like IRrecv but the timer only runs while a frame arrives. Same interrupt numbers.
+//IRrecvHybrid My_Receiver(0);
 
 IRdecode My_Decoder;
+IRanalyzer My_Analyzer;
+unsigned char kHz=38;
 IRTYPES Old_Type;
 unsigned long Old_Value;
 void setup()
@@ -42,6 +49,7 @@ void Tab(void) {Serial.print("\t");};
 void loop() {
   if (My_Receiver.GetResults(&My_Decoder)) {
     My_Decoder.decode();
+    My_Analyzer.add(&My_Decoder);
     if( (My_Decoder.decode_type != Old_Type) || (My_Decoder.value != Old_Value)) {
       Serial.println(F("Resetting counters"));
       for(i=0;i<RAWBUF;i++) {
@@ -110,6 +118,8 @@ void loop() {
     Serial.print(F("\n\nMark Above/Below="));RATIO(aaam,baam);
     Serial.print(F("\nSpace Above/Below="));RATIO(aaas,baas);
     Serial.println();
+    Serial.println(F("\nAll keys so far"));
+    My_Analyzer.DumpResults(kHz);
     delay(500);
     My_Receiver.resume();
   };
@@ -0,0 +1,69 @@
+/* Example program for from IRLib – an Arduino library for infrared encoding and decoding
+ * Version 1.6   (in development)
+ * Copyright 2014 by Chris Young http://cyborg5.com
+ */
+/*
+ * IRLib: IRbitbang - measure the carrier made by bit-bang output
+ * Uncomment IR_SEND_BIT_BANG in IRLibTimer.h and connect that pin to pin 8, the input
+ * capture pin of timer 1 on an Uno. For each frequency a mark is sent and timer 1 keeps
+ * the time of its last rising or falling edge. The difference between two marks of
+ * different length gives the length of a carrier cycle and the rising and falling edges
+ * of one mark give how long it is high. No interrupt is used to measure and the millis
+ * interrupt is held off during each mark so that nothing stretches a cycle.
+ */
+
+#include <IRLib.h>
+#include <IRLibTimer.h>
+
+#ifndef IR_SEND_BIT_BANG
+#error "Uncomment IR_SEND_BIT_BANG in IRLibTimer.h"
+#endif
+#if !defined(__AVR_ATmega328P__) && !defined(__AVR_ATmega168__)
+#error "This uses the timer 1 input capture pin of an Uno"
+#endif
+
+IRsendRaw My_Sender;
+unsigned char Frequencies[]={36,38,40,56};
+
+//CPU cycles from just before the mark until its last edge going up or down
+unsigned int Last_Edge(unsigned char kHz, unsigned int Mark, bool Rising) {
+  unsigned int Buf[2]={Mark, 100};
+  TCCR1A=0;
+  TCCR1B=(Rising? _BV(ICES1): 0) | _BV(CS10);
+  TIMSK0&=~_BV(TOIE0);
+  TCNT1=0;
+  My_Sender.send(Buf,2,kHz);
+  TIMSK0|=_BV(TOIE0);
+  return ICR1;
+}
+
+void Measure(unsigned char kHz) {
+  Serial.flush();//the serial interrupt would disturb the marks too
+  unsigned int Short=Last_Edge(kHz,1000,true);
+  unsigned int Long=Last_Edge(kHz,2000,true);
+  unsigned int Fall=Last_Edge(kHz,2000,false);
+  unsigned int Expected=IR_BIT_BANG_CYCLES(kHz);
+  unsigned int n=(Long-Short+Expected/2)/Expected;//carrier cycles between the last edges
+  float Period=(float)(Long-Short)/n;
+  float Achieved=F_CPU/1000.0/Period;
+  float Duty=100.0*(Fall-Long)/Period;
+  Serial.print(kHz,DEC); Serial.print(F(" kHz: "));
+  Serial.print(Achieved,2); Serial.print(F(" kHz ("));
+  Serial.print(100.0*(Achieved-kHz)/kHz,2); Serial.print(F("%) high "));
+  Serial.print(Duty,1); Serial.print(F("% ("));
+  Serial.print(Duty-100.0/3,1); Serial.print(F(" points) from "));
+  Serial.print(Period,1); Serial.print(F(" and ")); Serial.print(Fall-Long,DEC);
+  Serial.print(F(" cycles, expected "));
+  Serial.print(3*(IR_BIT_BANG_ON_LOOPS(kHz)+IR_BIT_BANG_OFF_LOOPS(kHz))+8,DEC);
+  Serial.print(F(" and ")); Serial.println(3*IR_BIT_BANG_ON_LOOPS(kHz)+2,DEC);
+}
+
+void setup()
+{
+  Serial.begin(9600);
+  delay(2000);while(!Serial);//delay for Leonardo
+  for(unsigned char i=0; i<sizeof(Frequencies); i++) Measure(Frequencies[i]);
+}
+
+void loop() {
+}
@@ -18,6 +18,8 @@
  * The logic is:
  * If an IR code is received, record it.
  * If a serial character is received, send the IR code.
+ * Unknown codes are also printed packed, ready to paste into a sketch which sends them
+ * from flash with IRsendRaw::send_P.
  */
 
 #include <IRLib.h>
@@ -57,6 +59,19 @@ void setup()
   My_Receiver.enableIRIn(); // Start the receiver
 }
 
+// Prints a raw code as a PROGMEM array for IRsendRaw::send_P
+void printPacked(void) {
+  unsigned char Packed[RAWBUF*2];
+  unsigned int Len=IRsendRaw::pack(rawCodes,rawCount,38,Packed,sizeof(Packed));
+  if(!Len) return;
+  Serial.print(F("const unsigned char Code[] PROGMEM={"));
+  for(unsigned int i=0; i<Len; i++) {
+    if(i) Serial.print(',');
+    Serial.print(Packed[i],DEC);
+  }
+  Serial.println(F("};"));
+}
+
 // Stores the code for later playback
 void storeCode(void) {
   GotNew=true;
@@ -72,6 +87,7 @@ void storeCode(void) {
       rawCodes[i - 1] = My_Decoder.rawbuf[i];
     };
     My_Decoder.DumpResults();
+    printPacked();
     codeType=UNKNOWN;
   }
   else {
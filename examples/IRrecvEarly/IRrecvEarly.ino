@@ -0,0 +1,42 @@
+/* Example program for from IRLib – an Arduino library for infrared encoding and decoding
+ * Version 1.6   (in development)
+ * Copyright 2014 by Chris Young http://cyborg5.com
+ */
+/*
+ * IRLib: IRrecvEarly - act on a code as soon as its last bit arrives
+ * An IR detector/demodulator must be connected to the input RECV_PIN.
+ * IRdecodeStream recognizes NEC, Sony, Panasonic_Old, NECx and JVC while the frame
+ * is still arriving instead of waiting for the gap after it. Anything else is
+ * handed over when it ends so that we can still try the other decoders on it.
+ */
+
+#include <IRLib.h>
+
+int RECV_PIN = 11;
+
+IRrecv My_Receiver(RECV_PIN);
+
+IRdecodeStream My_Stream;
+IRdecode My_Decoder;
+
+void setup()
+{
+  Serial.begin(9600);
+  delay(2000);while(!Serial);//delay for Leonardo
+  My_Receiver.enableIRIn(); // Start the receiver
+}
+
+void loop() {
+  if (My_Receiver.GetEarlyResults(&My_Stream)) {
+    if (My_Stream.decode_type == UNKNOWN) {
+      My_Decoder.copyBuf(&My_Stream);
+      My_Decoder.decode();
+      Serial.print(Pnames(My_Decoder.decode_type));
+      Serial.print(F(" ")); Serial.println(My_Decoder.value, HEX);
+    } else {
+      Serial.print(F("Early ")); Serial.print(Pnames(My_Stream.decode_type));
+      Serial.print(F(" ")); Serial.println(My_Stream.value, HEX);
+    }
+    My_Receiver.resume();
+  }
+}
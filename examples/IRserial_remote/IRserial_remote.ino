@@ -1,18 +1,58 @@
 /* Example program for from IRLib – an Arduino library for infrared encoding and decoding
- * Version 1.3   January 2014
+ * Version 1.6   (in development)
  * Copyright 2014 by Chris Young http://cyborg5.com
  * Use serial port to send codes. For details on this project see
-   http://tech.cyborg5.com/2013/05/30/irlib-tutorial-part-3-overview-sending-ir-codes/ 
+   http://tech.cyborg5.com/2013/05/30/irlib-tutorial-part-3-overview-sending-ir-codes/
+ */
+/*
+ * Codes may still be typed as text such as "5,37c107" or "3,180c,13": the protocol
+ * number, the value in hex and the number of bits if the protocol needs them. Once a
+ * binary frame has begun text is ignored until reset, so that the digits of a damaged
+ * frame can never be taken for a typed code.
+ * A program can instead send binary frames, which is what IRserial_remote.py does:
+ *   0xA5, length, payload of that many bytes, two check bytes
+ * The check bytes are the Fletcher-16 sums of the length and payload: Sum1 is the sum of
+ * the bytes modulo 255 and Sum2 the sum of the successive values of Sum1 modulo 255.
+ * The payload is a sequence number of the host's choice followed by any number of
+ * commands, all numbers low byte first:
+ *   'C', protocol, value (4 bytes), bits      send a code with IRsend::send
+ *   'R', kHz, count, count intervals (2 bytes each)   send with IRsendRaw::send
+ *   'G', milliseconds (2 bytes)               wait before the next command or frame
+ * Replies are framed the same way and start with the sequence number of the frame:
+ *   'A'                           the frame was accepted and its commands have started
+ *   'D', index, microseconds (4 bytes)   command number index was sent in that time
+ *   'E', error, index             1 bad check bytes, 2 bad command at index. The rest
+ *                                 of the frame is skipped.
+ * A frame which stops arriving for FRAME_TIMEOUT milliseconds, because bytes were lost,
+ * is dropped with error 1 as well.
+ * While one frame is sent the next one is read in between commands, so the transmitter
+ * need not wait for the host. A code takes longer to send than the serial buffer takes to
+ * fill, so the host must not send more than one frame ahead of the last 'A' and that
+ * frame must fit in the serial buffer, 64 bytes on most boards. Any frame can be sent
+ * once everything before it is done.
  */
 #include <IRLib.h>
 
 IRsend My_Sender;
 
+#define FRAME_SYNC 0xA5
+#define MAX_RAW 100
+#define FRAME_TIMEOUT 20
+
 int protocol;
 long code;
 int bits;
+
+unsigned char Incoming[255], Frame[255];    //frame being read and frame being sent
+unsigned char In_Len, In_Got, In_Sum1, In_Sum2;
+enum {HUNT, LENGTH, PAYLOAD, CHECK1, CHECK2} In_State=HUNT;
+bool In_Ready, Binary;
+unsigned char Frame_Len, Frame_Pos, Frame_Index;
+unsigned long Gap_Start, Gap, In_Time;
+unsigned int Raw[MAX_RAW];
+
 void setup() {
-  Serial.begin(9600);
+  Serial.begin(115200);
   delay(2000);while(!Serial);//delay for Leonardo
 }
 
@@ -42,14 +82,109 @@ void parseDelimiter () {
   }
 }
 
+void parseText() {
+  protocol = Serial.parseInt (); parseDelimiter();
+  code     = parseHex ();        parseDelimiter();
+  bits     = Serial.parseInt (); parseDelimiter();
+  Serial.print("Prot:");  Serial.print(protocol);
+  Serial.print(" Code:"); Serial.print(code,HEX);
+  Serial.print(" Bits:"); Serial.println(bits);
+  My_Sender.send(IRTYPES(protocol), code, bits);
+}
+
+void Add(unsigned char &Sum1, unsigned char &Sum2, unsigned char C) {
+  Sum1=(Sum1+C)%255; Sum2=(Sum2+Sum1)%255;
+}
+
+void Reply(const unsigned char *Payload, unsigned char Len) {
+  unsigned char Sum1=0, Sum2=0;
+  Serial.write(FRAME_SYNC); Serial.write(Len); Add(Sum1,Sum2,Len);
+  for(unsigned char i=0; i<Len; i++) {Serial.write(Payload[i]); Add(Sum1,Sum2,Payload[i]);}
+  Serial.write(Sum1); Serial.write(Sum2);
+}
+
+void Reply_Error(unsigned char Seq, unsigned char Error, unsigned char Index) {
+  unsigned char Payload[4]={Seq,'E',Error,Index};
+  Reply(Payload,4);
+}
+
+bool Sending(void) {
+  return Frame_Pos<Frame_Len;
+}
+
+//Reads whatever has arrived of the next frame. Text is only read until the first frame.
+void Receive(void) {
+  if (In_State!=HUNT && !Serial.available() && millis()-In_Time>FRAME_TIMEOUT) {
+    In_State=HUNT; Reply_Error(Incoming[0],1,0);
+  }
+  while (!In_Ready && Serial.available()>0) {
+    if (In_State==HUNT) {
+      int C=Serial.peek();
+      if (C==FRAME_SYNC) {Serial.read(); In_State=LENGTH; Binary=true; In_Time=millis();}
+      else if (!Binary && isDigit(C)) parseText();
+      else Serial.read();
+      continue;
+    }
+    unsigned char C=Serial.read(); In_Time=millis();
+    switch (In_State) {
+      case LENGTH:  In_Sum1=In_Sum2=0; Add(In_Sum1,In_Sum2,C); In_Len=C; In_Got=0; In_State= C? PAYLOAD: HUNT; break;
+      case PAYLOAD: Add(In_Sum1,In_Sum2,C); Incoming[In_Got++]=C; if (In_Got==In_Len) In_State=CHECK1; break;
+      case CHECK1:  In_State= (C==In_Sum1)? CHECK2: HUNT; if (In_State==HUNT) Reply_Error(Incoming[0],1,0); break;
+      case CHECK2:  In_State=HUNT; if (C==In_Sum2) In_Ready=true; else Reply_Error(Incoming[0],1,0); break;
+      default: break;
+    }
+  }
+}
+
+unsigned long Get_Number(unsigned char Pos, unsigned char Bytes) {
+  unsigned long Value=0;
+  while (Bytes--) Value=(Value<<8) | Frame[Pos+Bytes];
+  return Value;
+}
+
+//Sends the next command of the frame. Returns its length or 0 if it isn't a valid one.
+unsigned char Execute(void) {
+  unsigned char P=Frame_Pos, Left=Frame_Len-P;
+  switch (Frame[P]) {
+    case 'C':
+      if (Left<7 || !Frame[P+1] || Frame[P+1]>=HASH_CODE) return 0;
+      My_Sender.send(IRTYPES(Frame[P+1]), Get_Number(P+2,4), Frame[P+6]);
+      return 7;
+    case 'R': {
+      if (Left<3) return 0;
+      unsigned char Count=Frame[P+2];
+      if (Count>MAX_RAW || Left<3+2*Count) return 0;
+      for (unsigned char i=0; i<Count; i++) Raw[i]=Get_Number(P+3+2*i,2);
+      My_Sender.IRsendRaw::send(Raw, Count, Frame[P+1]);
+      return 3+2*Count;
+    }
+    case 'G':
+      if (Left<3) return 0;
+      Gap_Start=millis(); Gap=Get_Number(P+1,2);
+      return 3;
+  }
+  return 0;
+}
+
 void loop() {
-  if (Serial.available ()>0) {
-    protocol = Serial.parseInt (); parseDelimiter();
-    code     = parseHex ();        parseDelimiter();
-    bits     = Serial.parseInt (); parseDelimiter();
-    Serial.print("Prot:");  Serial.print(protocol);
-    Serial.print(" Code:"); Serial.print(code,HEX);
-    Serial.print(" Bits:"); Serial.println(bits);
-    My_Sender.send(IRTYPES(protocol), code, bits);   
+  Receive();
+  if (Gap) {
+    if (millis()-Gap_Start<Gap) return;
+    Gap=0;
+  }
+  if (!Sending() && In_Ready) {
+    memcpy(Frame,Incoming,In_Len); Frame_Len=In_Len; Frame_Pos=1; Frame_Index=0;
+    In_Ready=false;
+    unsigned char Payload[2]={Frame[0],'A'};
+    Reply(Payload,2);
   }
+  if (!Sending()) return;
+  unsigned long Start=micros();
+  unsigned char Len=Execute();
+  if (!Len) {Reply_Error(Frame[0],2,Frame_Index); Frame_Pos=Frame_Len; return;}
+  unsigned long Time=micros()-Start;
+  unsigned char Payload[7]={Frame[0],'D',Frame_Index,(unsigned char)Time,(unsigned char)(Time>>8),
+                            (unsigned char)(Time>>16),(unsigned char)(Time>>24)};
+  Reply(Payload,7);
+  Frame_Pos+=Len; Frame_Index++;
 }
@@ -5,11 +5,11 @@
 # since IR signals to a cable box in TV.
 
 # Import all of the necessary pieces of code
-import serial, sys, pygame, pygame.mixer
+import serial, sys, struct, pygame, pygame.mixer
 from pygame.locals import *
 
 # You will have to edit this to the proper port and speed
-ser = serial.Serial('COM4', 9600)
+ser = serial.Serial('COM4', 115200)
 
 pygame.init()
 # Established screen size, size of buttons and position
@@ -61,6 +61,102 @@ IR_Codes= ("3,180c,13","5,37c107","5,36d924","5,37d904",\
            "5,36d125","5,37d105","5,363139","3,1810,13",\
            "5,37b908","5,373119","3,180d,13","3,1811,13",\
            )
+
+# Codes are sent to the Arduino as binary frames. See IRserial_remote.ino
+# for the details: 0xA5, the length, the payload and two Fletcher-16 check
+# bytes. The payload is a sequence number followed by one or more commands.
+SYNC=0xA5
+RX_BUFFER=64   # size of the Arduino serial buffer
+
+def Fletcher(data):
+    sum1=sum2=0
+    for b in bytearray(data):
+        sum1=(sum1+b)%255; sum2=(sum2+sum1)%255
+    return bytearray([sum1,sum2])
+
+def Make_Frame(payload):
+    data=bytearray([len(payload)])+bytearray(payload)
+    return bytearray([SYNC])+data+Fletcher(data)
+
+# The commands, all numbers low byte first
+def Code_Command(protocol,value,bits=0):
+    return struct.pack('<BBLB',ord('C'),protocol,value,bits)
+def Raw_Command(intervals,khz=38):
+    return struct.pack('<BBB%dH'%len(intervals),ord('R'),khz,len(intervals),*intervals)
+def Gap_Command(ms):
+    return struct.pack('<BH',ord('G'),ms)
+
+# Turns "5,37c107" or "3,180c,13" into a command
+def Text_Command(text):
+    fields=text.split(',')
+    bits=int(fields[2]) if len(fields)>2 else 0
+    return Code_Command(int(fields[0]),int(fields[1],16),bits)
+
+# Sends frames as fast as the Arduino can take them and reads its replies.
+# One frame may be sent beyond the last one the Arduino accepted as long
+# as it fits in the serial buffer. Any frame may be sent when it is idle.
+class IRLink:
+    def __init__(self,port):
+        self.port=port
+        self.queue=[]        # frames not sent yet
+        self.seq=0
+        self.ahead=None      # frame sent but not accepted yet
+        self.left=0          # commands still to be done in the accepted frame
+        self.counts={}
+        self.rx=bytearray()
+    # Sends any number of commands in one frame
+    def send(self,*commands):
+        self.seq=(self.seq+1)%256
+        payload=bytearray([self.seq])+bytearray(b''.join(commands))
+        if len(payload)>255: raise ValueError("frame is too long")
+        self.counts[self.seq]=len(commands)
+        self.queue.append((self.seq,Make_Frame(payload)))
+        self.pump()
+    def idle(self):
+        return self.ahead is None and self.left==0 and not self.queue
+    def pump(self):
+        if not self.queue or self.ahead is not None: return
+        seq,frame=self.queue[0]
+        if self.left and len(frame)>RX_BUFFER: return
+        self.queue.pop(0)
+        self.port.write(bytes(frame))
+        self.ahead=seq
+    # Call often. Reads whatever replies have arrived.
+    def poll(self):
+        n=self.port.inWaiting()
+        if n: self.rx+=bytearray(self.port.read(n))
+        while True:
+            start=self.rx.find(bytearray([SYNC]))
+            if start<0: self.rx=bytearray(); break
+            del self.rx[:start]
+            if len(self.rx)<2 or len(self.rx)<self.rx[1]+4: break
+            n=self.rx[1]
+            if self.rx[n+2:n+4]!=Fletcher(self.rx[1:n+2]):
+                del self.rx[0]; continue
+            self.reply(self.rx[2:n+2])
+            del self.rx[:n+4]
+        self.pump()
+    def reply(self,p):
+        if len(p)<2: return
+        seq,kind=p[0],chr(p[1])
+        if kind=='A':
+            self.ahead=None
+            self.left=self.counts.pop(seq,0)
+        elif kind=='D' and len(p)>=7:
+            self.left=max(self.left-1,0)
+            self.done(seq,p[2],struct.unpack('<L',bytes(p[3:7]))[0])
+        elif kind=='E' and len(p)>=4:
+            if p[2]==1:      # never accepted
+                self.ahead=None
+            else:
+                self.left=0
+            print("Frame %d error %d at command %d"%(seq,p[2],p[3]))
+    # Override to use the timing of each command
+    def done(self,seq,index,usec):
+        print("Frame %d command %d sent in %dus"%(seq,index,usec))
+
+link=IRLink(ser)
+
 # This function gets called to shut everything down
 def Finished():
     pygame.quit()
@@ -108,6 +204,7 @@ Click=pygame.mixer.Sound("click.wav")
 previous=-1
 
 while 1:
+    link.poll()
     for event in pygame.event.get():
         if event.type == pygame.QUIT:
             Finished()
@@ -117,7 +214,7 @@ while 1:
             i=ComputeButton()  #which button did we click
             if i>=0:
                 Click.play()  #play the sound
-            ser.write(IR_Codes[i])  #send the codes
+                link.send(Text_Command(IR_Codes[i]))  #send the codes
         elif event.type==MOUSEMOTION:
             i=ComputeButton() #which button are we over
             if i!=previous:   #difference in the last one?
@@ -0,0 +1,137 @@
+/* Arduino.h for the IRLib host build - a simulated Arduino HAL
+ * Copyright 2014 by Chris Young http://cyborg5.com
+ *
+ * This header stands in for the Arduino core when IRLib.cpp is compiled on a desktop
+ * machine. It provides just enough of the Arduino API, the AVR timer registers used
+ * by IRLibTimer.h and a Serial object so that the unmodified library compiles.
+ * Time, pins, timer interrupts and attachInterrupt are all simulated. See IRLibSim.h
+ * for the functions that drive the simulation and README.txt for how to build.
+ */
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+#include "avr/pgmspace.h"
+#include "avr/interrupt.h"
+
+#define ARDUINO 105
+#ifndef F_CPU
+#define F_CPU 16000000L
+#endif
+
+#define HIGH 0x1
+#define LOW  0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define min(a,b) ((a)<(b)?(a):(b))
+#define max(a,b) ((a)>(b)?(a):(b))
+#define _BV(bit) (1 << (bit))
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+unsigned long micros(void);
+unsigned long millis(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void attachInterrupt(uint8_t inum, void (*handler)(void), int mode);
+void detachInterrupt(uint8_t inum);
+#define interrupts() sei()
+#define noInterrupts() cli()
+inline boolean isDigit(int c) {return isdigit(c);}
+
+/* Simulated 8-bit I/O register. Writes are reported to the simulator so that
+ * it can follow timer configuration and the carrier output of the sender.
+ */
+class IRLibSimReg8 {
+public:
+  constexpr IRLibSimReg8(void (*hook)(uint8_t oldval, uint8_t newval)=0): v(0), onWrite(hook) {}
+  operator uint8_t() const {return v;}
+  IRLibSimReg8 &operator=(uint8_t x) {set(x); return *this;}
+  IRLibSimReg8 &operator|=(uint8_t x) {set(v|x); return *this;}
+  IRLibSimReg8 &operator&=(uint8_t x) {set(v&x); return *this;}
+  IRLibSimReg8 &operator^=(uint8_t x) {set(v^x); return *this;}
+private:
+  void set(uint8_t x) {uint8_t old=v; v=x; if(onWrite) onWrite(old,x);}
+  uint8_t v;
+  void (*onWrite)(uint8_t oldval, uint8_t newval);
+};
+
+/* Input port registers of 32 bits as on the Due. Pin n is bit n%32 of port n/32 and reads
+ * 1 when high. They are only valid after IRLibSim_Reset.
+ */
+extern volatile uint32_t IRLibSim_Ports[];
+#define digitalPinToPort(pin) ((pin)/32)
+#define digitalPinToBitMask(pin) (1UL<<((pin)%32))
+#define portInputRegister(port) (&IRLibSim_Ports[port])
+
+// Timer 2 is what IRLibTimer.h selects when it does not recognize the processor.
+extern IRLibSimReg8 TCCR2A, TCCR2B, OCR2A, OCR2B, TCNT2, TIMSK2, PORTB;
+#define WGM20 0
+#define WGM21 1
+#define COM2B0 4
+#define COM2B1 5
+#define COM2A0 6
+#define COM2A1 7
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define WGM22 3
+#define TOIE2 0
+#define OCIE2A 1
+#define OCIE2B 2
+
+// Binary constants from the Arduino core which are used by IRLibTimer.h
+#define B00100000 32
+#define B11011111 223
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+class HardwareSerial {
+public:
+  void begin(unsigned long baud);
+  void end(void) {}
+  int available(void);
+  int read(void);
+  int peek(void);
+  long parseInt(void);
+  void flush(void);
+  size_t write(uint8_t c);
+  size_t write(const uint8_t *buf, size_t len);
+  operator bool() const {return true;}
+  size_t print(const __FlashStringHelper *s) {return print((const char *)s);}
+  size_t print(const char *s);
+  size_t print(char c) {return write((uint8_t)c);}
+  size_t print(unsigned char n, int base=DEC) {return printNumber(n,base);}
+  size_t print(int n, int base=DEC) {return print((long)n,base);}
+  size_t print(unsigned int n, int base=DEC) {return printNumber(n,base);}
+  size_t print(long n, int base=DEC);
+  size_t print(unsigned long n, int base=DEC) {return printNumber(n,base);}
+  size_t print(double n, int digits=2);
+  size_t println(void) {return print("\r\n");}
+  template <typename T> size_t println(T x) {size_t n=print(x); return n+println();}
+  template <typename T> size_t println(T x, int fmt) {size_t n=print(x,fmt); return n+println();}
+private:
+  size_t printNumber(unsigned long n, int base);
+  int timedPeek(void);
+};
+extern HardwareSerial Serial;
+
+#endif //Arduino_h
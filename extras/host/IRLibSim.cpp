@@ -0,0 +1,377 @@
+/* IRLibSim.cpp from the IRLib host build - a simulated Arduino HAL
+ * Copyright 2014 by Chris Young http://cyborg5.com
+ *
+ * Implements the Arduino functions declared in extras/host/Arduino.h on top of
+ * a virtual clock. See IRLibSim.h for a description of the simulation.
+ */
+#include <stdio.h>
+#include "IRLibSim.h"
+
+// Provided by IRLib.cpp when USE_IRRECV and USE_IRSEND_ASYNC are defined. Weak so we link without them.
+extern "C" void TIMER2_COMPA_vect(void) __attribute__((weak));
+extern "C" void TIMER2_OVF_vect(void) __attribute__((weak));
+
+static void Timer2_Output(uint8_t oldval, uint8_t newval);
+static void Timer2_Top(uint8_t oldval, uint8_t newval);
+IRLibSimReg8 TCCR2A(Timer2_Output), TCCR2B, OCR2A(Timer2_Top), OCR2B, TCNT2, TIMSK2, PORTB;
+HardwareSerial Serial;
+
+static unsigned long Now;
+static bool PinLow[IRLIB_SIM_PINS]; //inverted so that static initialization leaves inputs high
+volatile uint32_t IRLibSim_Ports[IRLIB_SIM_PINS/32];
+static bool Enabled=true, InISR;
+static bool TickArmed;
+static unsigned long NextTick, Ticks;
+static bool CarrierArmed;
+static unsigned long long NextCarrier; //in CPU cycles as a carrier period is not whole microseconds
+#define CYCLES_PER_USEC (F_CPU/1000000)
+static unsigned char KHz;
+static void (*Mark_Hook)(void);
+
+static struct {unsigned long when; unsigned char pin, level;} Edges[IRLIB_SIM_EDGES];
+static unsigned int EdgeHead, EdgeCount;
+
+static struct {unsigned long when; bool on;} Trace[IRLIB_SIM_EDGES];
+static unsigned int TraceLen;
+// Changes of output pins made with digitalWrite, for the gates of IRsendMulti
+static struct {unsigned long when; unsigned char pin; bool high;} Gates[IRLIB_SIM_EDGES];
+static unsigned int GateLen;
+// Serial input on its way and waiting to be read, and captured output
+static unsigned long Baud=9600;
+static struct {unsigned long when; unsigned char c;} SerialIn[IRLIB_SIM_SERIAL_QUEUE];
+static unsigned int InHead, InCount;
+static unsigned char RxBuf[IRLIB_SIM_SERIAL_BUFFER];
+static unsigned int RxHead, RxCount;
+static unsigned long LastArrival, Lost;
+static bool Capture;
+static unsigned char Captured[IRLIB_SIM_SERIAL_QUEUE];
+static unsigned long CapturedWhen[IRLIB_SIM_SERIAL_QUEUE];
+static unsigned int CapturedLen;
+
+// attachInterrupt numbers map to the same pins as Pin_from_Intr on an Uno
+static const unsigned char IntrPin[]={2,3};
+#define SIM_INTRS (sizeof IntrPin)
+static void (*IntrHandler[SIM_INTRS])(void);
+static int IntrMode[SIM_INTRS];
+
+// Interrupts which became due while interrupts were disabled
+#define SIM_PENDING 8
+static void (*Pending[SIM_PENDING])(void);
+static unsigned char PendingCount;
+
+static void Dispatch(void (*handler)(void)) {
+  if(!handler) return;
+  if(!Enabled) {
+    for(unsigned char i=0; i<PendingCount; i++) if(Pending[i]==handler) return;
+    if(PendingCount<SIM_PENDING) Pending[PendingCount++]=handler;
+    return;
+  }
+  InISR=true; Enabled=false;
+  handler();
+  InISR=false; Enabled=true;
+}
+
+void cli(void) {Enabled=false;}
+void sei(void) {
+  Enabled=true;
+  while(PendingCount && !InISR) {
+    void (*handler)(void)=Pending[0];
+    memmove(Pending,Pending+1,--PendingCount*sizeof Pending[0]);
+    Dispatch(handler);
+  }
+}
+
+/* The receive timer runs in CTC mode. Work out its period in microseconds from the
+ * prescaler bits in TCCR2B and the top value in OCR2A. Returns zero if stopped.
+ */
+static unsigned long TickPeriod(void) {
+  static const unsigned int Prescale[8]={0,1,8,32,64,128,256,1024};
+  unsigned long P=Prescale[TCCR2B & 7];
+  return P*OCR2A/(F_CPU/1000000);
+}
+
+static bool TickEnabled(void) {
+  return (TIMSK2 & _BV(OCIE2A)) && !(TCCR2B & _BV(WGM22)) && TickPeriod();
+}
+
+/* While sending, the timer counts up to OCR2A and back down once per carrier cycle and
+ * the overflow interrupt comes at the bottom. Returns the period in CPU cycles.
+ */
+static unsigned long CarrierPeriod(void) {
+  static const unsigned int Prescale[8]={0,1,8,32,64,128,256,1024};
+  return 2UL*Prescale[TCCR2B & 7]*OCR2A;
+}
+
+static bool CarrierEnabled(void) {
+  return (TIMSK2 & _BV(TOIE2)) && (TCCR2B & _BV(WGM22)) && CarrierPeriod();
+}
+
+static void SetPin(unsigned char pin, unsigned char level) {
+  if(pin>=IRLIB_SIM_PINS) return;
+  bool WasLow=PinLow[pin];
+  PinLow[pin]=(level==LOW);
+  if(WasLow==PinLow[pin]) return;
+  IRLibSim_Ports[digitalPinToPort(pin)]^=digitalPinToBitMask(pin);
+  for(unsigned char i=0; i<SIM_INTRS; i++) {
+    if(IntrPin[i]!=pin || !IntrHandler[i]) continue;
+    if(IntrMode[i]==CHANGE || (IntrMode[i]==FALLING && level==LOW) || (IntrMode[i]==RISING && level==HIGH))
+      Dispatch(IntrHandler[i]);
+  }
+}
+
+void IRLibSim_Run(unsigned long usec) {
+  if(InISR) {Now+=usec; return;}
+  unsigned long Target=Now+usec;
+  for(;;) {
+    unsigned long Next=Target;
+    if(EdgeCount && Edges[EdgeHead].when<Next) Next=Edges[EdgeHead].when;
+    bool Ticking=TickEnabled();
+    if(Ticking) {
+      if(!TickArmed) {NextTick=Now+TickPeriod(); TickArmed=true;}
+      if(NextTick<Next) Next=NextTick;
+    } else TickArmed=false;
+    bool Carrier=CarrierEnabled();
+    if(Carrier) {
+      if(!CarrierArmed) {NextCarrier=(unsigned long long)Now*CYCLES_PER_USEC+CarrierPeriod(); CarrierArmed=true;}
+      unsigned long At=(NextCarrier+CYCLES_PER_USEC-1)/CYCLES_PER_USEC;
+      if(At<Next) Next=At;
+    } else CarrierArmed=false;
+    if(Next>Now) Now=Next;
+    while(EdgeCount && Edges[EdgeHead].when<=Now) {
+      SetPin(Edges[EdgeHead].pin,Edges[EdgeHead].level);
+      EdgeHead=(EdgeHead+1)%IRLIB_SIM_EDGES; EdgeCount--;
+    }
+    if(Ticking && NextTick<=Now) {
+      NextTick+=TickPeriod();
+      Ticks++;
+      Dispatch(TIMER2_COMPA_vect);
+    }
+    if(Carrier && NextCarrier<=(unsigned long long)Now*CYCLES_PER_USEC) {
+      NextCarrier+=CarrierPeriod();
+      Dispatch(TIMER2_OVF_vect);
+    }
+    if(Now>=Target) break;
+  }
+}
+
+void IRLibSim_Reset(void) {
+  Enabled=true; InISR=false; PendingCount=0;
+  TCCR2A=0; TCCR2B=0; OCR2A=0; OCR2B=0; TCNT2=0; TIMSK2=0; PORTB=0;
+  Now=0; TickArmed=false; Ticks=0; KHz=0; CarrierArmed=false;
+  for(unsigned char i=0; i<IRLIB_SIM_PINS; i++) PinLow[i]=false;
+  for(unsigned char i=0; i<IRLIB_SIM_PINS/32; i++) IRLibSim_Ports[i]=0xffffffff;
+  for(unsigned char i=0; i<SIM_INTRS; i++) IntrHandler[i]=0;
+  EdgeHead=EdgeCount=0;
+  TraceLen=GateLen=0;
+  InHead=InCount=RxHead=RxCount=0; LastArrival=Lost=0; CapturedLen=0;
+}
+
+unsigned long IRLibSim_Now(void) {return Now;}
+unsigned long IRLibSim_Ticks(void) {return Ticks;}
+bool IRLibSim_InISR(void) {return InISR;}
+
+void IRLibSim_Schedule(unsigned char pin, unsigned long when, unsigned char level) {
+  if(EdgeCount>=IRLIB_SIM_EDGES) {fprintf(stderr,"IRLibSim: edge queue full\n"); exit(1);}
+  //Changes for another pin may come earlier than the last one scheduled. Keep them in order.
+  unsigned int i=(EdgeHead+EdgeCount++)%IRLIB_SIM_EDGES;
+  while(i!=EdgeHead) {
+    unsigned int Prev=(i+IRLIB_SIM_EDGES-1)%IRLIB_SIM_EDGES;
+    if(Edges[Prev].when<=when) break;
+    Edges[i]=Edges[Prev]; i=Prev;
+  }
+  Edges[i].when=when; Edges[i].pin=pin; Edges[i].level=level;
+}
+
+unsigned long IRLibSim_Play(unsigned char pin, unsigned long start, const unsigned int *buf, unsigned int len) {
+  for(unsigned int i=0; i<len; i++) {
+    unsigned long Length=buf[i];
+    if(i & 1) Length-=min(Length,(unsigned long)IRLIB_SIM_MARK_EXCESS);
+    else Length+=IRLIB_SIM_MARK_EXCESS;
+    IRLibSim_Schedule(pin,start,(i & 1)? HIGH: LOW);
+    start+=Length;
+  }
+  IRLibSim_Schedule(pin,start,HIGH);
+  return start;
+}
+
+/* Connecting or disconnecting OC2B from the PWM generator is what turns the IR LED
+ * on and off. A mark of zero length produces two edges at the same instant which
+ * cancel each other.
+ */
+static void Timer2_Output(uint8_t oldval, uint8_t newval) {
+  if(!((oldval^newval) & _BV(COM2B1))) return;
+  bool On=newval & _BV(COM2B1);
+  if(On && Mark_Hook) Mark_Hook();
+  if(TraceLen && Trace[TraceLen-1].when==Now && Trace[TraceLen-1].on!=On) {TraceLen--; return;}
+  if(TraceLen<IRLIB_SIM_EDGES) {Trace[TraceLen].when=Now; Trace[TraceLen++].on=On;}
+}
+
+// In PWM mode 5 OCR2A is the top of the count and therefore sets the carrier frequency.
+static void Timer2_Top(uint8_t oldval, uint8_t newval) {
+  (void)oldval;
+  if((TCCR2B & _BV(WGM22)) && newval) KHz=(F_CPU/2000+newval/2)/newval;
+}
+
+void IRLibSim_ClearTrace(void) {TraceLen=GateLen=0;}
+unsigned char IRLibSim_CarrierKHz(void) {return KHz;}
+void IRLibSim_OnMark(void (*Hook)(void)) {Mark_Hook=Hook;}
+
+unsigned int IRLibSim_GetTrace(unsigned int *buf, unsigned int maxlen) {
+  unsigned int i=0, n=0;
+  while(i<TraceLen && !Trace[i].on) i++;
+  for(; i<TraceLen && n<maxlen; i++) {
+    unsigned long End=(i+1<TraceLen)? Trace[i+1].when: Now;
+    buf[n++]=End-Trace[i].when;
+  }
+  return n;
+}
+
+/* Walks the carrier edges and the gate pin's changes together in time order. The emitter is
+ * lit while both are on. Changes at the same instant are applied together before looking.
+ */
+unsigned int IRLibSim_GetGatedTrace(unsigned char pin, unsigned int *buf, unsigned int maxlen) {
+  unsigned int t=0, g=0, n=0;
+  bool Carrier=false, Gate=false, Lit=false;
+  unsigned long Since=0;
+  for(;;) {
+    while(g<GateLen && Gates[g].pin!=pin) g++;
+    if(t>=TraceLen && g>=GateLen) break;
+    unsigned long When=(g>=GateLen || (t<TraceLen && Trace[t].when<=Gates[g].when))? Trace[t].when: Gates[g].when;
+    while(t<TraceLen && Trace[t].when==When) Carrier=Trace[t++].on;
+    for(; g<GateLen && Gates[g].when==When; g++) if(Gates[g].pin==pin) Gate=Gates[g].high;
+    if((Carrier && Gate)==Lit) continue;
+    if((Lit || n) && n<maxlen) buf[n++]=When-Since;
+    Lit=!Lit; Since=When;
+  }
+  if((Lit || n) && n<maxlen) buf[n++]=Now-Since;
+  return n;
+}
+
+/*
+ * The Arduino API
+ */
+void pinMode(uint8_t pin, uint8_t mode) {
+  if(mode==INPUT_PULLUP) SetPin(pin,HIGH);
+}
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if(pin<IRLIB_SIM_PINS && PinLow[pin]!=(val==LOW) && GateLen<IRLIB_SIM_EDGES) {
+    Gates[GateLen].when=Now; Gates[GateLen].pin=pin; Gates[GateLen++].high=(val!=LOW);
+  }
+  SetPin(pin,val);
+}
+int digitalRead(uint8_t pin) {return (pin<IRLIB_SIM_PINS && PinLow[pin])? LOW: HIGH;}
+
+unsigned long micros(void) {
+  unsigned long T=Now;
+  if(!InISR) IRLibSim_Run(IRLIB_SIM_MICROS_STEP);
+  return T;
+}
+unsigned long millis(void) {return micros()/1000;}
+void delay(unsigned long ms) {IRLibSim_Run(ms*1000);}
+void delayMicroseconds(unsigned int us) {IRLibSim_Run(us);}
+
+void attachInterrupt(uint8_t inum, void (*handler)(void), int mode) {
+  if(inum>=SIM_INTRS) return;
+  IntrHandler[inum]=handler; IntrMode[inum]=mode;
+}
+void detachInterrupt(uint8_t inum) {
+  if(inum<SIM_INTRS) IntrHandler[inum]=0;
+}
+
+/*
+ * Serial input comes from IRLibSim_SerialFeed. Each byte is one start bit, eight data
+ * bits and one stop bit. Bytes which have arrived since the sketch last looked are moved
+ * into the receive buffer then, which is the same as the receive interrupt doing it as
+ * they arrive because nothing can be read in between.
+ */
+void IRLibSim_SerialFeed(const unsigned char *buf, unsigned int len) {
+  for(unsigned int i=0; i<len; i++) {
+    if(InCount>=IRLIB_SIM_SERIAL_QUEUE) {fprintf(stderr,"IRLibSim: serial queue full\n"); exit(1);}
+    LastArrival=max(LastArrival,Now)+10000000UL/Baud;
+    unsigned int j=(InHead+InCount++)%IRLIB_SIM_SERIAL_QUEUE;
+    SerialIn[j].when=LastArrival; SerialIn[j].c=buf[i];
+  }
+}
+unsigned long IRLibSim_SerialLost(void) {return Lost;}
+
+static void Arrive(void) {
+  while(InCount && SerialIn[InHead].when<=Now) {
+    if(RxCount<IRLIB_SIM_SERIAL_BUFFER) RxBuf[(RxHead+RxCount++)%IRLIB_SIM_SERIAL_BUFFER]=SerialIn[InHead].c;
+    else Lost++;
+    InHead=(InHead+1)%IRLIB_SIM_SERIAL_QUEUE; InCount--;
+  }
+}
+
+void HardwareSerial::begin(unsigned long baud) {Baud=baud;}
+int HardwareSerial::available(void) {Arrive(); return RxCount;}
+int HardwareSerial::peek(void) {Arrive(); return RxCount? RxBuf[RxHead]: -1;}
+int HardwareSerial::read(void) {
+  int c=peek();
+  if(c>=0) {RxHead=(RxHead+1)%IRLIB_SIM_SERIAL_BUFFER; RxCount--;}
+  return c;
+}
+// Stream waits up to its default timeout of one second for each character
+int HardwareSerial::timedPeek(void) {
+  unsigned long Start=Now; int c;
+  while((c=peek())<0 && Now-Start<1000000UL) IRLibSim_Run(100);
+  return c;
+}
+// As Stream::parseInt: skips anything but digits and minus, returns zero on timeout
+long HardwareSerial::parseInt(void) {
+  int c; long Value=0; bool Negative=false;
+  while((c=timedPeek())>=0 && c!='-' && !isdigit(c)) read();
+  if(c<0) return 0;
+  do {
+    if(c=='-') Negative=true; else Value=Value*10+c-'0';
+    read();
+  } while((c=timedPeek())>=0 && isdigit(c));
+  return Negative? -Value: Value;
+}
+
+/*
+ * Serial output goes to stdout unless it is being captured.
+ */
+void IRLibSim_CaptureSerial(bool on) {Capture=on;}
+unsigned int IRLibSim_GetSerial(unsigned char *buf, unsigned int maxlen, unsigned long *When) {
+  unsigned int Len=min(maxlen,CapturedLen);
+  memcpy(buf,Captured,Len);
+  if(When) memcpy(When,CapturedWhen,Len*sizeof When[0]);
+  CapturedLen-=Len;
+  memmove(Captured,Captured+Len,CapturedLen);
+  memmove(CapturedWhen,CapturedWhen+Len,CapturedLen*sizeof CapturedWhen[0]);
+  return Len;
+}
+static size_t Output(const void *buf, size_t len) {
+  if(!Capture) return fwrite(buf,1,len,stdout);
+  if(CapturedLen+len>IRLIB_SIM_SERIAL_QUEUE) {fprintf(stderr,"IRLibSim: serial output full\n"); exit(1);}
+  memcpy(Captured+CapturedLen,buf,len);
+  for(size_t i=0; i<len; i++) CapturedWhen[CapturedLen++]=Now;
+  return len;
+}
+void HardwareSerial::flush(void) {fflush(stdout);}
+size_t HardwareSerial::write(uint8_t c) {return Output(&c,1);}
+size_t HardwareSerial::write(const uint8_t *buf, size_t len) {return Output(buf,len);}
+size_t HardwareSerial::print(const char *s) {return Output(s,strlen(s));}
+
+// Non-decimal output of a negative number shows its 32-bit pattern just as on an AVR
+size_t HardwareSerial::print(long n, int base) {
+  if(base==DEC && n<0) return print('-')+printNumber(-n,DEC);
+  return printNumber((uint32_t)n,base);
+}
+
+size_t HardwareSerial::print(double n, int digits) {
+  char buf[64];
+  snprintf(buf,sizeof buf,"%.*f",digits,n);
+  return print(buf);
+}
+
+size_t HardwareSerial::printNumber(unsigned long n, int base) {
+  char buf[8*sizeof(long)+1]; char *p=&buf[sizeof buf-1];
+  *p='\0';
+  if(base<2) base=10;
+  do {
+    unsigned char d=n%base; n/=base;
+    *--p= d<10? '0'+d: 'A'+d-10;
+  } while(n);
+  return print(p);
+}
@@ -0,0 +1,81 @@
+/* IRLibSim.h from the IRLib host build - a simulated Arduino HAL
+ * Copyright 2014 by Chris Young http://cyborg5.com
+ *
+ * These functions drive the simulated hardware behind extras/host/Arduino.h.
+ * Time is virtual and measured in microseconds. It only moves forward when the
+ * program calls IRLibSim_Run, delay, delayMicroseconds or micros. While time moves
+ * forward the simulator applies scheduled pin changes, calls interrupt handlers
+ * that were attached with attachInterrupt and calls the timer ISR that IRrecv uses
+ * whenever the timer registers say that it is enabled.
+ * The sender side is observed through the timer registers. Every time the PWM output
+ * is connected or disconnected the simulator records an edge. You can then retrieve
+ * the transmitted marks and spaces and play them back into a receiver pin.
+ */
+#ifndef IRLibSim_h
+#define IRLibSim_h
+
+#include <Arduino.h>
+
+#define IRLIB_SIM_PINS 64
+#define IRLIB_SIM_EDGES 4096
+/* A polling loop such as IRrecvLoop::GetResults would never see time pass
+ * if micros() returned the same value every time. The resolution of micros()
+ * on a 16 MHz AVR is 4us so each call outside of an interrupt advances
+ * the clock by that much.
+ */
+#define IRLIB_SIM_MICROS_STEP 4
+/* Real demodulators report marks longer and spaces shorter than what was sent.
+ * IRLibSim_Play does the same by the amount that IRrecvBase::Mark_Excess
+ * removes by default.
+ */
+#define IRLIB_SIM_MARK_EXCESS 100
+
+void IRLibSim_Reset(void);          //clock to zero, all inputs high, nothing scheduled or received
+unsigned long IRLibSim_Now(void);   //current virtual time in microseconds
+void IRLibSim_Run(unsigned long usec); //advance virtual time
+bool IRLibSim_InISR(void);          //true while an interrupt handler is being called
+unsigned long IRLibSim_Ticks(void); //timer interrupts since IRLibSim_Reset
+
+/* Schedule a change of an input pin at an absolute virtual time. Changes of one
+ * pin must be scheduled in time order but those of different pins may overlap.
+ */
+void IRLibSim_Schedule(unsigned char pin, unsigned long when, unsigned char level);
+/* Schedule the output of an IR demodulator. Marks are LOW and spaces are HIGH
+ * just as with a real TSOP type receiver. The buffer is in the same format as
+ * IRsendRaw uses: even entries are marks, odd entries are spaces. Each mark is
+ * stretched by IRLIB_SIM_MARK_EXCESS at the expense of the space that follows.
+ * Returns the time at which the last interval ends.
+ */
+unsigned long IRLibSim_Play(unsigned char pin, unsigned long start, const unsigned int *buf, unsigned int len);
+
+/* Each time the sender connects or disconnects its PWM output an edge is recorded.
+ * IRLibSim_GetTrace converts them into alternating marks and spaces in the IRsendRaw
+ * format. The final space runs up to the current time. Returns the number of entries.
+ */
+void IRLibSim_ClearTrace(void);
+unsigned int IRLibSim_GetTrace(unsigned int *buf, unsigned int maxlen);
+unsigned char IRLibSim_CarrierKHz(void); //frequency most recently set by enableIROut
+/* Called each time the PWM output is connected, before the edge is recorded. A
+ * benchmark can use it to see when a mark begins. NULL removes it.
+ */
+void IRLibSim_OnMark(void (*Hook)(void));
+/* The same for one of the emitters of IRsendMulti, which is lit while the carrier is on
+ * and its gate pin is HIGH.
+ */
+unsigned int IRLibSim_GetGatedTrace(unsigned char pin, unsigned int *buf, unsigned int maxlen);
+
+/* Bytes given to IRLibSim_SerialFeed arrive one after another at the rate set by
+ * Serial.begin, after any still on their way. As on an AVR only IRLIB_SIM_SERIAL_BUFFER
+ * of them wait to be read and any more are lost. IRLibSim_SerialLost counts those.
+ * Serial output goes to stdout unless IRLibSim_CaptureSerial turns capturing on. Then
+ * it is kept until IRLibSim_GetSerial returns and removes it, with the time each byte
+ * was written if When is given.
+ */
+#define IRLIB_SIM_SERIAL_BUFFER 64
+#define IRLIB_SIM_SERIAL_QUEUE 8192
+void IRLibSim_SerialFeed(const unsigned char *buf, unsigned int len);
+unsigned long IRLibSim_SerialLost(void);
+void IRLibSim_CaptureSerial(bool on);
+unsigned int IRLibSim_GetSerial(unsigned char *buf, unsigned int maxlen, unsigned long *When=0);
+
+#endif //IRLibSim_h
@@ -0,0 +1,106 @@
+/* IRactions.cpp from the IRLib host build - a simulated Arduino HAL
+ * Copyright 2014 by Chris Young http://cyborg5.com
+ *
+ * Writes the sorted PROGMEM table that IRfindAction searches. Reads one button per line
+ * from standard input: the name of its action, the protocol as it is named in IRLib.h
+ * (NEC, SONY, ... or HASH_CODE) or its number, and the value or hash. Blank lines and
+ * those starting with # are skipped. Several codes may share an action. For example
+ *	Power       NEC        0x61a0f00f
+ *	Power       HASH_CODE  0x9d7e0c4b
+ *	Volume_Up   SONY       0x490
+ * Actions are numbered in the order they first appear and written as an enum, followed
+ * by the table sorted by protocol and value. The table name is the first argument or
+ * My_Actions. The table is checked with IRcheckActions and every code is looked up with
+ * IRfindAction before it is written, so the sketch will find what was listed.
+ *	IRactions My_Actions <buttons.txt >actions.h
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <IRLib.h>
+
+#define MAX_BUTTONS 4096
+#define MAX_NAME 64
+
+const struct {const char *Name; IRTYPES Type;} Types[]={
+  {"NEC",NEC}, {"SONY",SONY}, {"RC5",RC5}, {"RC6",RC6}, {"PANASONIC_OLD",PANASONIC_OLD},
+  {"JVC",JVC}, {"NECX",NECX}, {"HASH_CODE",HASH_CODE}
+};
+#define TYPES (sizeof Types/sizeof Types[0])
+
+char Names[MAX_BUTTONS][MAX_NAME];
+unsigned int Num_Names;
+IRaction Table[MAX_BUTTONS];
+unsigned int Count;
+
+bool Before(const IRaction &A, const IRaction &B) {
+  return A.Type<B.Type || (A.Type==B.Type && A.Value<B.Value);
+}
+
+const char *Type_Name(IRTYPES Type) {
+  for(unsigned int i=0; i<TYPES; i++) if(Types[i].Type==Type) return Types[i].Name;
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  const char *Table_Name= (argc>1)? argv[1]: "My_Actions";
+  char Line[256], Name[MAX_NAME], Type[MAX_NAME], Value[MAX_NAME];
+  unsigned int Line_No=0;
+  while(fgets(Line,sizeof Line,stdin)) {
+    Line_No++;
+    if(Line[0]=='#' || sscanf(Line,"%63s",Name)!=1) continue;
+    if(sscanf(Line,"%63s %63s %63s",Name,Type,Value)!=3) {
+      fprintf(stderr,"line %u: expected an action, a protocol and a value\n",Line_No); return 1;
+    }
+    if(Count==MAX_BUTTONS) {fprintf(stderr,"more than %d buttons\n",MAX_BUTTONS); return 1;}
+    IRaction &E=Table[Count];
+    char *End;
+    E.Type=0;
+    for(unsigned int i=0; i<TYPES; i++) if(!strcmp(Type,Types[i].Name)) E.Type=Types[i].Type;
+    if(!E.Type) {
+      long Number=strtol(Type,&End,0);
+      E.Type= (*End || Number<=0 || Number>LAST_PROTOCOL)? 0: Number;
+    }
+    if(E.Type<=0 || E.Type>LAST_PROTOCOL) {fprintf(stderr,"line %u: unknown protocol %s\n",Line_No,Type); return 1;}
+    E.Value=strtoul(Value,&End,0);
+    if(*End) {fprintf(stderr,"line %u: bad value %s\n",Line_No,Value); return 1;}
+    for(E.Action=0; E.Action<Num_Names && strcmp(Names[E.Action],Name); E.Action++);
+    if(E.Action==Num_Names) strcpy(Names[Num_Names++],Name);
+    Count++;
+  }
+  std::stable_sort(Table,Table+Count,Before);
+  //The same code listed twice is fine if it is for the same action
+  unsigned int Kept=0;
+  for(unsigned int i=0; i<Count; i++) {
+    if(Kept && !Before(Table[Kept-1],Table[i])) {
+      if(Table[Kept-1].Action==Table[i].Action) continue;
+      fprintf(stderr,"0x%lx of protocol %d is both %s and %s\n",Table[i].Value,Table[i].Type,
+        Names[Table[Kept-1].Action],Names[Table[i].Action]);
+      return 1;
+    }
+    Table[Kept++]=Table[i];
+  }
+  Count=Kept;
+  if(!IRcheckActions(Table,Count)) {fprintf(stderr,"IRcheckActions rejects the table\n"); return 1;}
+  for(unsigned int i=0; i<Count; i++) {
+    unsigned int Action;
+    if(!IRfindAction(Table,Count,Table[i].Type,Table[i].Value,&Action) || Action!=Table[i].Action) {
+      fprintf(stderr,"IRfindAction doesn't find 0x%lx\n",Table[i].Value); return 1;
+    }
+  }
+  printf("//Written by extras/host/IRactions. Look codes up with IRfindAction.\n");
+  printf("enum {");
+  for(unsigned int i=0; i<Num_Names; i++) printf(i? ", %s": "%s",Names[i]);
+  printf("};\n");
+  printf("const IRaction %s[] PROGMEM={\n",Table_Name);
+  for(unsigned int i=0; i<Count; i++) {
+    const char *Type_Str=Type_Name(Table[i].Type);
+    if(Type_Str) printf("  {%s, 0x%lx, %s}",Type_Str,Table[i].Value,Names[Table[i].Action]);
+    else printf("  {%d, 0x%lx, %s}",Table[i].Type,Table[i].Value,Names[Table[i].Action]);
+    printf(i+1<Count? ",\n": "\n");
+  }
+  printf("};\n");
+  fprintf(stderr,"%u codes for %u actions\n",Count,Num_Names);
+  return 0;
+}
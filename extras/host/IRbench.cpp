@@ -0,0 +1,367 @@
+/* IRbench.cpp from the IRLib host build - a simulated Arduino HAL
+ * Copyright 2014 by Chris Young http://cyborg5.com
+ *
+ * Decode benchmark. A corpus of realistic captures is made by sending codes with
+ * IRsend, adding timing jitter to what the simulated LED transmitted and capturing
+ * it again with IRrecv at its usual 50us resolution. Noise frames of random length
+ * are added to represent signals that no decoder recognizes.
+ * Each frame is then decoded many times by IRdecode::decode, by the decoder for its
+ * own protocol alone and by IRdecodeHash::decode. The difference between the first
+ * two is the time IRdecode spends rejecting the frame in the decoders it tries first.
+ * Results are in nanoseconds and, on x86, time stamp counter cycles per frame.
+ * Each frame is timed several times and the fastest trial is kept. Worst is the
+ * slowest single frame of the group.
+ * Finally the cost of a single interval comparison is measured for the floating
+ * point MATCH of version 1.51, the integer MATCH and a precomputed IRmatchWindow,
+ * each with an expected value that is only known at run time as in decodeGeneric.
+ * Then the time from calling send to the start of the first mark is measured for IRsend
+ * and for IRsendRaw sending the same frame from a buffer. The median is given with the spread up to the 99th percentile. Each includes reading
+ * the clock and the simulated enableIROut, which are the same for all.
+ * Then IRfindAction looks codes up in tables of different sizes, against comparing with
+ * each entry in turn as a chain of if statements would.
+ * Last the IRrecv timer interrupt is called directly with one IRrecv enabled, then two and
+ * so on up to IRLIB_MAX_RECEIVERS, while each input sees frames of 20 intervals. This gives
+ * the cost of the interrupt for each receiver. Build with -DIRLIB_MAX_RECEIVERS=8 to see
+ * how it grows.
+ */
+#include <stdio.h>
+#include <chrono>
+#include <algorithm>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_CYCLES() __rdtsc()
+#else
+#define BENCH_CYCLES() 0
+#endif
+#include "IRLibSim.h"
+#include <IRLib.h>
+#include <IRLibMatch.h>
+#include <IRLibRData.h>
+
+#define RECV_PIN 11
+#define JITTER 40      //+/- microseconds added to every sent interval
+#define VALUES 8       //different codes sent per group
+#define REPEATS 2000   //times each frame is decoded per trial
+#define TRIALS 5       //the fastest trial is reported to filter out scheduling noise
+#define MAX_FRAMES 64  //per group
+
+struct Frame {unsigned char len; unsigned int buf[RAWBUF];};
+struct Group {
+  const char *Name; IRTYPES Type; unsigned int Data2; unsigned long Mask; //Data2 is bits or JVC first
+  IRdecodeBase *Own; //the decoder for this protocol alone
+  Frame Frames[MAX_FRAMES]; unsigned int Count;
+};
+
+IRsend My_Sender;
+IRdecode My_Decoder;
+IRdecodeHash My_Hash;
+IRdecodeNEC Dec_NEC;
+IRdecodeSony Dec_Sony;
+IRdecodeRC5 Dec_RC5;
+IRdecodeRC6 Dec_RC6;
+IRdecodePanasonic_Old Dec_Panasonic;
+IRdecodeJVC Dec_JVC;
+IRdecodeNECx Dec_NECx;
+
+Group Groups[]={ //Frames and Count are filled in by the capture
+  {"NEC",          NEC,           0, 0xffffffff, &Dec_NEC,       {}, 0},
+  {"NEC repeat",   NEC,           0, 0,          &Dec_NEC,       {}, 0},
+  {"NECx",         NECX,          0, 0xffffffff, &Dec_NECx,      {}, 0},
+  {"Sony 8",       SONY,          8, 0xff,       &Dec_Sony,      {}, 0},
+  {"Sony 12",      SONY,         12, 0xfff,      &Dec_Sony,      {}, 0},
+  {"Sony 15",      SONY,         15, 0x7fff,     &Dec_Sony,      {}, 0},
+  {"Sony 20",      SONY,         20, 0xfffff,    &Dec_Sony,      {}, 0},
+  {"RC5",          RC5,          13, 0x1fff,     &Dec_RC5,       {}, 0},
+  {"RC6",          RC6,          20, 0xfffff,    &Dec_RC6,       {}, 0},
+  {"Panasonic Old",PANASONIC_OLD, 0, 0x3fffff,   &Dec_Panasonic, {}, 0},
+  {"JVC",          JVC,           1, 0xffff,     &Dec_JVC,       {}, 0},
+  {"Unknown",      UNKNOWN,       0, 0,          NULL,           {}, 0}
+};
+#define GROUPS (sizeof Groups/sizeof Groups[0])
+
+// Deterministic so that every run benchmarks the same corpus
+unsigned long Seed=2463534242UL;
+unsigned long Random(unsigned long n) {
+  Seed^=Seed<<13; Seed&=0xffffffff; Seed^=Seed>>17; Seed^=Seed<<5; Seed&=0xffffffff;
+  return Seed%n;
+}
+
+unsigned int Trace[IRLIB_SIM_EDGES];
+
+// Sends one code and appends every frame that IRrecv captures from it to the group
+void Capture(Group *G, unsigned long Value) {
+  IRLibSim_Reset();
+  if(G->Type==NEC && !G->Mask) Value=REPEAT;
+  My_Sender.send(G->Type,Value,G->Data2);
+  unsigned int Len=IRLibSim_GetTrace(Trace,IRLIB_SIM_EDGES);
+  for(unsigned int i=0; i<Len; i++) {
+    if(Trace[i]>JITTER*2) Trace[i]+=Random(2*JITTER+1)-JITTER;
+  }
+  IRLibSim_Reset();
+  IRrecv My_Receiver(RECV_PIN);
+  IRdecodeBase Capt;
+  My_Receiver.enableIRIn();
+  unsigned long End=IRLibSim_Play(RECV_PIN,10000,Trace,Len);
+  while(IRLibSim_Now()<End+20000 && G->Count<MAX_FRAMES) {
+    IRLibSim_Run(1000);
+    if(My_Receiver.GetResults(&Capt)) {
+      Frame *F=&G->Frames[G->Count++];
+      F->len=Capt.rawlen;
+      for(unsigned char i=0; i<Capt.rawlen; i++) F->buf[i]=Capt.rawbuf[i];
+      My_Receiver.resume();
+    }
+  }
+}
+
+void Noise(Group *G) {
+  while(G->Count<MAX_FRAMES) {
+    Frame *F=&G->Frames[G->Count++];
+    F->len=10+Random(RAWBUF-10);
+    F->buf[0]=5000+Random(20000);
+    for(unsigned char i=1; i<F->len; i++) F->buf[i]=150+Random(3000);
+  }
+}
+
+struct Result {double ns, cycles, worst; unsigned int ok;};
+
+// Decodes every frame of the group REPEATS times with the given decoder
+Result Time(Group *G, IRdecodeBase *D) {
+  Result R={0,0,0,0};
+  for(unsigned int f=0; f<G->Count; f++) {
+    Frame *F=&G->Frames[f];
+    D->UseExtnBuf(F->buf);
+    D->rawlen=F->len;
+    D->decode_type=UNKNOWN;
+    if(D->decode() && D->decode_type==G->Type) R.ok++;
+    double ns=1e30, cycles=1e30;
+    for(unsigned char t=0; t<TRIALS; t++) {
+      std::chrono::steady_clock::time_point Start=std::chrono::steady_clock::now();
+      unsigned long long C0=BENCH_CYCLES();
+      for(unsigned int r=0; r<REPEATS; r++) D->decode();
+      unsigned long long C1=BENCH_CYCLES();
+      double Elapsed=std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now()-Start).count();
+      ns=min(ns,Elapsed/REPEATS);
+      cycles=min(cycles,double(C1-C0)/REPEATS);
+    }
+    R.ns+=ns; R.cycles+=cycles;
+    if(ns>R.worst) R.worst=ns;
+  }
+  if(G->Count) {R.ns/=G->Count; R.cycles/=G->Count;}
+  return R;
+}
+
+// The percentage MATCH as it was in version 1.51
+#define FLOAT_MATCH(v,e) ((v) >= (unsigned int)((e)*(1.0 - PERCENT_TOLERANCE/100.)) \
+                       && (v) <= (unsigned int)((e)*(1.0 + PERCENT_TOLERANCE/100.) + 1))
+#define MATCH_INTERVALS 4096
+#define MATCH_EXPECTED 8
+
+unsigned int Intervals[MATCH_INTERVALS];
+volatile unsigned int Expected[MATCH_EXPECTED]={564,600,889,1692,2400,4512,525,833};
+
+// Times one way of comparing every interval against every expected value
+template <class Compare> void TimeMatch(const char *Name, Compare C) {
+  double ns=1e30; unsigned long Hits=0;
+  for(unsigned char t=0; t<TRIALS; t++) {
+    Hits=0;
+    std::chrono::steady_clock::time_point Start=std::chrono::steady_clock::now();
+    for(unsigned char e=0; e<MATCH_EXPECTED; e++) Hits+=C(Expected[e]);
+    double Elapsed=std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now()-Start).count();
+    ns=min(ns,Elapsed/(MATCH_EXPECTED*MATCH_INTERVALS));
+  }
+  printf("%-14s %8.2f ns/interval %6lu matched\n",Name,ns,Hits);
+}
+
+struct FloatMatch {unsigned long operator()(unsigned int e) {
+  unsigned long n=0; for(unsigned int i=0; i<MATCH_INTERVALS; i++) n+=FLOAT_MATCH(Intervals[i],e); return n;}};
+struct IntMatch {unsigned long operator()(unsigned int e) {
+  unsigned long n=0; for(unsigned int i=0; i<MATCH_INTERVALS; i++) n+=MATCH(Intervals[i],e); return n;}};
+struct WindowMatch {unsigned long operator()(unsigned int e) {
+  IRmatchWindow W(e);
+  unsigned long n=0; for(unsigned int i=0; i<MATCH_INTERVALS; i++) n+=W.match(Intervals[i]); return n;}};
+
+void BenchMatch(void) {
+  unsigned int n=0;
+  for(unsigned char g=0; g<GROUPS && n<MATCH_INTERVALS; g++)
+    for(unsigned int f=0; f<Groups[g].Count && n<MATCH_INTERVALS; f++)
+      for(unsigned char i=1; i<Groups[g].Frames[f].len && n<MATCH_INTERVALS; i++) Intervals[n++]=Groups[g].Frames[f].buf[i];
+  while(n<MATCH_INTERVALS) {Intervals[n]=Intervals[n%64]; n++;}
+  printf("\n");
+  TimeMatch("float MATCH",FloatMatch());
+  TimeMatch("integer MATCH",IntMatch());
+  TimeMatch("IRmatchWindow",WindowMatch());
+}
+
+/* The time from calling send to the start of the first mark is what delays a code behind the
+ * button press or serial command that asked for it, and what varies from one send to the next.
+ * The simulator calls Mark_Begins when the carrier is switched on. It notes the time and
+ * throws so that the rest of the frame is not sent.
+ */
+struct First_Mark {};
+std::chrono::steady_clock::time_point Mark_Time;
+void Mark_Begins(void) {Mark_Time=std::chrono::steady_clock::now(); throw First_Mark();}
+
+IRsendRaw My_Raw;
+unsigned int Raw_Buf[IRLIB_SIM_EDGES]; unsigned int Raw_Len;
+
+unsigned long Send_Value(Group *G) {return (G->Type==NEC && !G->Mask)? REPEAT: 0x5a5a5a5a & G->Mask;}
+struct Direct {void operator()(Group *G) {My_Sender.send(G->Type,Send_Value(G),G->Data2);}};
+struct Raw {void operator()(Group *) {My_Raw.send(Raw_Buf,Raw_Len,38);}};
+
+struct Latency {double median, jitter;}; //jitter is the 99th percentile less the fastest
+double Samples[TRIALS*REPEATS];
+
+template <class Method> Latency TimeFirstMark(Method M, Group *G) {
+  unsigned int n=0;
+  for(unsigned int r=0; r<TRIALS*REPEATS; r++) {
+    std::chrono::steady_clock::time_point Start=std::chrono::steady_clock::now();
+    try {M(G);} catch(First_Mark &) {Samples[n++]=std::chrono::duration<double,std::nano>(Mark_Time-Start).count();}
+  }
+  Latency L={-1,-1};
+  if(!n) return L;
+  std::sort(Samples,Samples+n);
+  L.median=Samples[n/2]; L.jitter=Samples[n*99/100]-Samples[0];
+  return L;
+}
+
+void BenchSend(void) {
+  printf("\n%-14s | %-15s | %-15s\n","to first mark","IRsend","IRsendRaw");
+  printf("%-14s | %7s %7s | %7s %7s\n","protocol","ns","jitter","ns","jitter");
+  IRLibSim_OnMark(Mark_Begins);
+  for(unsigned char g=0; g<GROUPS; g++) {
+    Group *G=&Groups[g];
+    if(G->Type==UNKNOWN) continue;
+    IRLibSim_ClearTrace();
+    IRLibSim_OnMark(NULL);
+    My_Sender.send(G->Type,Send_Value(G),G->Data2);
+    Raw_Len=IRLibSim_GetTrace(Raw_Buf,IRLIB_SIM_EDGES)-1;
+    IRLibSim_OnMark(Mark_Begins);
+    Latency Sent=TimeFirstMark(Direct(),G), Raw_Sent=TimeFirstMark(Raw(),G);
+    printf("%-14s | %7.1f %7.1f | %7.1f %7.1f\n",G->Name,Sent.median,Sent.jitter,Raw_Sent.median,Raw_Sent.jitter);
+  }
+  IRLibSim_OnMark(NULL);
+  IRLibSim_ClearTrace();
+}
+
+#define MAX_ACTIONS 1024
+#define LOOKUPS 4096
+IRaction Actions[MAX_ACTIONS];
+struct {IRTYPES Type; unsigned long Value;} Lookups[LOOKUPS];
+
+bool Action_Before(const IRaction &A, const IRaction &B) {
+  return A.Type<B.Type || (A.Type==B.Type && A.Value<B.Value);
+}
+
+struct Search {unsigned long operator()(unsigned int n) {
+  unsigned long Found=0; unsigned int Action;
+  for(unsigned int i=0; i<LOOKUPS; i++)
+    if(IRfindAction(Actions,n,Lookups[i].Type,Lookups[i].Value,&Action)) Found+=Action+1;
+  return Found;}};
+struct Chain {unsigned long operator()(unsigned int n) {
+  unsigned long Found=0;
+  for(unsigned int i=0; i<LOOKUPS; i++)
+    for(unsigned int j=0; j<n; j++)
+      if(Actions[j].Type==Lookups[i].Type && Actions[j].Value==Lookups[i].Value) {Found+=Actions[j].Action+1; break;}
+  return Found;}};
+
+template <class Method> double TimeLookup(Method M, unsigned int n, unsigned long *Found) {
+  double ns=1e30;
+  for(unsigned char t=0; t<TRIALS; t++) {
+    std::chrono::steady_clock::time_point Start=std::chrono::steady_clock::now();
+    *Found=M(n);
+    double Elapsed=std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now()-Start).count();
+    ns=min(ns,Elapsed/LOOKUPS);
+  }
+  return ns;
+}
+
+//Half of the codes looked up are in the table
+void BenchActions(void) {
+  printf("\n%-14s %12s %12s\n","buttons","search ns","chain ns");
+  for(unsigned int n=16; n<=MAX_ACTIONS; n*=4) {
+    for(unsigned int i=0; i<n; i++) {
+      Actions[i].Type=1+Random(NECX); Actions[i].Value=(Random(0x10000)<<16)|Random(0x10000); Actions[i].Action=i;
+    }
+    for(unsigned int i=0; i<LOOKUPS; i++) {
+      Lookups[i].Type=Actions[Random(n)].Type; Lookups[i].Value=Actions[Random(n)].Value;
+      if(i%2) {unsigned int j=Random(n); Lookups[i].Type=Actions[j].Type; Lookups[i].Value=Actions[j].Value;}
+    }
+    std::sort(Actions,Actions+n,Action_Before);
+    unsigned long Searched, Chained;
+    double Search_ns=TimeLookup(Search(),n,&Searched), Chain_ns=TimeLookup(Chain(),n,&Chained);
+    printf("%-14u %12.1f %12.1f%s\n",n,Search_ns,Chain_ns,(Searched==Chained && IRcheckActions(Actions,n))? "": " differ");
+  }
+}
+
+/* Every input toggles each 10 ticks for the first half of a 400 tick cycle and is then
+ * quiet long enough for the frame to end. Between cycles the receivers are resumed,
+ * which is not timed. The first receiver uses irparams, which the capture of the corpus
+ * already put in the interrupt's table, so that there are exactly n in it.
+ */
+extern "C" void TIMER2_COMPA_vect(void); //what IRLibTimer.h picks on the host
+#define ISR_CYCLES 500
+#define ISR_FIRST_PIN 8
+volatile irparams_t ISR_States[IRLIB_MAX_RECEIVERS]; //the first is not used
+IRrecv *ISR_Receivers[IRLIB_MAX_RECEIVERS];
+
+void BenchISR(void) {
+  printf("\n%-14s %12s %12s %14s\n","receivers","ns/tick","cycles/tick","ns/receiver");
+  IRLibSim_Reset();
+  double First=0;
+  for(unsigned char n=1; n<=IRLIB_MAX_RECEIVERS; n++) {
+    ISR_Receivers[n-1]=new IRrecv(ISR_FIRST_PIN+n-1,n>1? &ISR_States[n-1]: &irparams);
+    if(!ISR_Receivers[n-1]->enableIRIn()) {printf("%-14u no room\n",n); return;}
+    double ns=1e30, Cycles=1e30;
+    for(unsigned char t=0; t<TRIALS; t++) {
+      double Elapsed=0, Counted=0;
+      for(unsigned int c=0; c<ISR_CYCLES; c++) {
+        for(unsigned char i=0; i<n; i++) ISR_Receivers[i]->resume();
+        std::chrono::steady_clock::time_point Start=std::chrono::steady_clock::now();
+        unsigned long long Start_Cycles=BENCH_CYCLES();
+        for(unsigned int Tick=0; Tick<400; Tick++) {
+          if(Tick<200 && Tick%10==0) IRLibSim_Ports[digitalPinToPort(ISR_FIRST_PIN)]^=((1UL<<n)-1)<<(ISR_FIRST_PIN%32);
+          TIMER2_COMPA_vect();
+        }
+        Counted+=BENCH_CYCLES()-Start_Cycles;
+        Elapsed+=std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now()-Start).count();
+      }
+      ns=min(ns,Elapsed/(ISR_CYCLES*400.0)); Cycles=min(Cycles,Counted/(ISR_CYCLES*400.0));
+    }
+    if(n==1) First=ns;
+    if(n==1) printf("%-14u %12.1f %12.0f %14s\n",n,ns,Cycles,"-");
+    else printf("%-14u %12.1f %12.0f %14.1f\n",n,ns,Cycles,(ns-First)/(n-1));
+  }
+}
+
+int main(void) {
+  for(unsigned char g=0; g<GROUPS; g++) {
+    Group *G=&Groups[g];
+    if(G->Type==UNKNOWN) Noise(G);
+    else for(unsigned char v=0; v<VALUES; v++) Capture(G,(((unsigned long)Random(0x10000)<<16)|Random(0x10000)) & G->Mask);
+  }
+  printf("%-14s %6s | %-28s | %-28s | %-20s | %s\n","","","IRdecode::decode","own decoder","IRdecodeHash","rejecting");
+  printf("%-14s %6s | %8s %8s %8s  ok | %8s %8s %8s  ok | %8s %8s  | %s\n","protocol","frames",
+         "ns","cycles","worst","ns","cycles","worst","ns","cycles","ns/frame");
+  Result Total={0,0,0,0}; unsigned int Frames=0;
+  for(unsigned char g=0; g<GROUPS; g++) {
+    Group *G=&Groups[g];
+    Result All=Time(G,&My_Decoder);
+    Result Hash=Time(G,&My_Hash);
+    printf("%-14s %6u | %8.1f %8.0f %8.1f %3u | ",G->Name,G->Count,All.ns,All.cycles,All.worst,All.ok);
+    if(G->Own) {
+      Result Own=Time(G,G->Own);
+      printf("%8.1f %8.0f %8.1f %3u | ",Own.ns,Own.cycles,Own.worst,Own.ok);
+      printf("%8.1f %8.0f  | %8.1f\n",Hash.ns,Hash.cycles,All.ns-Own.ns);
+    } else {
+      printf("%8s %8s %8s %3s | %8.1f %8.0f  | %8.1f\n","-","-","-","-",Hash.ns,Hash.cycles,All.ns);
+    }
+    Total.ns+=All.ns*G->Count; Total.cycles+=All.cycles*G->Count; Frames+=G->Count;
+    if(All.worst>Total.worst) Total.worst=All.worst;
+  }
+  printf("%-14s %6u | %8.1f %8.0f %8.1f\n","all",Frames,Total.ns/Frames,Total.cycles/Frames,Total.worst);
+  BenchMatch();
+  BenchSend();
+  BenchActions();
+  BenchISR();
+  return 0;
+}
@@ -0,0 +1,559 @@
+/* IRloopback.cpp from the IRLib host build - a simulated Arduino HAL
+ * Copyright 2014 by Chris Young http://cyborg5.com
+ *
+ * Sends a code in every supported protocol with IRsend, captures what the simulated
+ * IR LED transmitted and plays it back into each of the three receiver classes.
+ * Each capture is then decoded with IRdecode. This exercises the senders, receivers
+ * and decoders of the unmodified library without any hardware. IRrecvHybrid is also
+ * shown with the number of timer interrupts it took against IRrecv's for the same time.
+ * A 36 bit Samsung frame as sent by the Samsung36 example follows. It begins with the NECx
+ * header but is longer, so each receiver must capture all 78 intervals. Then NEC goes to
+ * an IRrecvLoop whose enableIRIn is never called, which version 1.51 allowed. A frame of
+ * 100 bits is then decoded by IRdecodePayload, which needs -DRAWBUF=400 to succeed, and
+ * IRrecvPCI gets NEC 5ms after the end of Sony.
+ * All receivers share irparams so the simulation is reset before each one. Otherwise
+ * the timer interrupt left running by IRrecv would corrupt the other captures.
+ * The interrupt driven receivers are also polled every 100us with GetEarlyResults to show
+ * how much sooner IRdecodeStream recognizes the frame than GetResults reports it. Build
+ * with -DIRLIB_PREDICT_END to have GetResults report NEC, Sony and the like without the gap.
+ * Finally a burst of frames is played while the receivers are only polled every 100ms,
+ * as a busy sketch might. How many survive depends on IRLIB_CAPTURE_SLOTS.
+ * Last IRsendMulti sends to two emitters, first one code on both and then a different
+ * code on each at the same time, and what each emitter transmitted is played into IRrecv.
+ * Each code is then packed by IRsendRaw::pack, sent with IRsendRaw::send_P and compared
+ * with what IRsend transmitted. Last each code is written as Pronto hex, sent from that
+ * with IRsendRaw::sendPronto and compared again, followed by a learned code of 144 pairs.
+ * IRanalyzer is then given four different codes of each protocol as IRrecv captured them.
+ * The description it works out is printed and each capture is decoded with it.
+ * Built with -DUSE_IRSEND_ASYNC it also queues two codes with IRsendAsync and counts how
+ * often the program loops while they are sent.
+ * Last NEC and Sony are played at the same time to two IRrecv and then to two IRrecvPCI.
+ * With the default IRLIB_MAX_RECEIVERS of 1 the second of each is refused. Build with
+ * -DIRLIB_MAX_RECEIVERS=2 to have both decoded. This comes last because the second
+ * receiver stays in the timer interrupt's table.
+ */
+#include <stdio.h>
+#include "IRLibSim.h"
+#include <IRLib.h>
+#include <IRLibRData.h>
+
+#define RECV_PIN 11
+#define LOOP_PIN 4
+#define PCI_INTR 0 //pin 2
+#define GATE_PIN0 5
+#define GATE_PIN1 6
+
+IRsend My_Sender;
+IRdecode My_Decoder;
+IRdecodeStream My_Stream;
+
+struct {IRTYPES Type; unsigned long Value; unsigned int Data2;} Codes[]={
+  {NEC,           0x61a0f00f, 0},
+  {SONY,          0x74bca,    20},
+  {RC5,           0x1184,     13},
+  {RC6,           0xc800f,    20},
+  {PANASONIC_OLD, 0x37c107,   0},
+  {JVC,           0xc2d0,     1},
+  {NECX,          0xe0e040bf, 0}
+};
+#define CODES (sizeof Codes/sizeof Codes[0])
+
+unsigned int Trace[IRLIB_SIM_EDGES];
+unsigned int TraceLen;
+
+void Report(const char *Receiver, bool Got) {
+  printf("  %-10s ",Receiver);
+  if(!Got) {printf("nothing received\n"); return;}
+  My_Decoder.decode();
+  printf("rawlen=%-3d ",My_Decoder.rawlen);
+  Serial.print(Pnames(My_Decoder.decode_type));
+  printf(" 0x%lx (%d bits)\n",My_Decoder.value,My_Decoder.bits);
+}
+
+//The timer driven receiver is polled in 1 ms steps the way a sketch would poll it in loop()
+bool CaptureIRrecv(void) {
+  IRLibSim_Reset();
+  IRrecv My_Receiver(RECV_PIN);
+  My_Receiver.enableIRIn();
+  unsigned long End=IRLibSim_Play(RECV_PIN,IRLibSim_Now()+10000,Trace,TraceLen);
+  bool Got=false;
+  while(!Got && IRLibSim_Now()<End+20000) {IRLibSim_Run(1000); Got=My_Receiver.GetResults(&My_Decoder);}
+  return Got;
+}
+
+void TryIRrecv(void) {
+  Report("IRrecv",CaptureIRrecv());
+}
+
+void TryIRrecvPCI(void) {
+  IRLibSim_Reset();
+  IRrecvPCI My_Receiver(PCI_INTR);
+  My_Receiver.enableIRIn();
+  unsigned long End=IRLibSim_Play(My_Receiver.getPinNum(),IRLibSim_Now()+10000,Trace,TraceLen);
+  bool Got=false;
+  while(!Got && IRLibSim_Now()<End+20000) {IRLibSim_Run(1000); Got=My_Receiver.GetResults(&My_Decoder);}
+  Report("IRrecvPCI",Got);
+}
+
+void TryIRrecvHybrid(void) {
+  IRLibSim_Reset();
+  IRrecvHybrid My_Receiver(PCI_INTR);
+  My_Receiver.enableIRIn();
+  unsigned long End=IRLibSim_Play(My_Receiver.getPinNum(),IRLibSim_Now()+10000,Trace,TraceLen);
+  bool Got=false;
+  while(!Got && IRLibSim_Now()<End+20000) {IRLibSim_Run(1000); Got=My_Receiver.GetResults(&My_Decoder);}
+  IRLibSim_Run(100000); //idle
+  Report("IRrecvHybrid",Got);
+  printf("  %-10s %lu timer interrupts in %lums against %lu\n","",IRLibSim_Ticks(),IRLibSim_Now()/1000,IRLibSim_Now()/50); //IRrecv ticks every 50us
+}
+
+//IRrecvLoop takes over until it has something, so schedule the signal first
+void TryIRrecvLoop(void) {
+  IRLibSim_Reset();
+  IRrecvLoop My_Receiver(LOOP_PIN);
+  My_Receiver.enableIRIn();
+  IRLibSim_Play(LOOP_PIN,IRLibSim_Now()+10000,Trace,TraceLen);
+  Report("IRrecvLoop",My_Receiver.GetResults(&My_Decoder));
+}
+
+//Time from the start of the frame until each method has a result
+template <class Receiver> void TryEarly(const char *Name, Receiver &My_Receiver, bool Early) {
+  My_Receiver.enableIRIn();
+  unsigned long Start=IRLibSim_Now()+10000;
+  unsigned long End=IRLibSim_Play(My_Receiver.getPinNum(),Start,Trace,TraceLen);
+  bool Got=false;
+  while(!Got && IRLibSim_Now()<End+20000) {
+    IRLibSim_Run(100);
+    Got=Early? My_Receiver.GetEarlyResults(&My_Stream): My_Receiver.GetResults(&My_Decoder);
+  }
+  if(!Early) {
+    printf("%.1fms\n",(IRLibSim_Now()-Start)/1000.0);
+    return;
+  }
+  printf("  %-10s ",Name);
+  if(!Got) {printf("nothing received\n"); return;}
+  Serial.print(Pnames(My_Stream.decode_type));
+  printf(" 0x%lx (%d bits) early at %.1fms, GetResults at ",My_Stream.value,My_Stream.bits,(IRLibSim_Now()-Start)/1000.0);
+}
+
+//The sender of the Samsung36 example
+class IRsendSamsung36: public virtual IRsendBase {
+public:
+  void send(unsigned long data, unsigned long data2);
+private:
+  void PutBits(unsigned long data, int nbits);
+};
+void IRsendSamsung36::PutBits(unsigned long data, int nbits) {
+  for (int i=0; i<nbits; i++) {
+    mark(500); space((data & 0x80000000)? 1500: 500);
+    data <<= 1;
+  }
+}
+void IRsendSamsung36::send(unsigned long data, unsigned long data2) {
+  data <<= 32-20; data2 <<= 32-16;
+  enableIROut(38);
+  mark(4500); space(4500);
+  PutBits(data2,16);
+  mark(500); space(4500);
+  PutBits(data,12);
+  space(68);
+  data <<= 12;
+  PutBits(data,8); mark(500);
+  space(118*500);
+}
+
+void TrySamsung36(void) {
+  IRsendSamsung36 My_Samsung;
+  IRLibSim_Reset();
+  My_Samsung.send(0x400bf,0x0707);
+  TraceLen=IRLibSim_GetTrace(Trace,IRLIB_SIM_EDGES);
+  printf("Sent Samsung36 0x400bf: %u intervals, 78 expected\n",TraceLen);
+  TryIRrecv();
+  TryIRrecvPCI();
+  TryIRrecvLoop();
+  TryIRrecvHybrid();
+}
+
+/* As in version 1.51 IRrecvLoop works without enableIRIn. It gets state of its own
+ * because irparams has been used by everything before.
+ */
+volatile irparams_t Loop_State;
+void TryLoopUnenabled(void) {
+  IRLibSim_Reset();
+  My_Sender.send(NEC,0x61a0f00f,0);
+  TraceLen=IRLibSim_GetTrace(Trace,IRLIB_SIM_EDGES);
+  printf("NEC to an IRrecvLoop that was never enabled\n");
+  IRLibSim_Reset();
+  IRrecvLoop My_Receiver(LOOP_PIN,&Loop_State);
+  IRLibSim_Play(LOOP_PIN,IRLibSim_Now()+10000,Trace,TraceLen);
+  Report("IRrecvLoop",My_Receiver.GetResults(&My_Decoder));
+}
+
+/* A 100 bit frame with the header of NEC, as many air conditioners send, decoded by
+ * IRdecodePayload. It only fits with -DRAWBUF=400. Otherwise the receivers stop at RAWBUF.
+ */
+#define LONG_BITS 100
+const IRprotocol Long_Protocol PROGMEM={9000, 4500, 560, 560, 1690, 560, 0, 38, LONG_BITS, true};
+const unsigned char Long_Data[(LONG_BITS+7)/8]={0xc3,0x5a,0x01,0xff,0x80,0x24,0x7e,0x00,0x99,0xa5,0x3c,0x0f,0x60};
+IRdecodePayload Long_Decoder(&Long_Protocol);
+
+void ReportLong(const char *Receiver, bool Got) {
+  printf("  %-10s ",Receiver);
+  if(!Got) {printf("nothing received\n"); return;}
+  printf("rawlen=%-3u ",(unsigned int)Long_Decoder.rawlen);
+  if(!Long_Decoder.decode()) {printf("not decoded\n"); return;}
+  printf("%u bits, %s\n",Long_Decoder.payload_bits,
+    memcmp(Long_Decoder.payload,Long_Data,sizeof Long_Data)? "NOT the payload sent": "the payload sent");
+}
+
+void TryPayload(void) {
+  unsigned int Buf[2*LONG_BITS+3]; unsigned int Len=0;
+  Buf[Len++]=9000; Buf[Len++]=4500;
+  for(unsigned int i=0; i<LONG_BITS; i++) {
+    Buf[Len++]=560; Buf[Len++]=(Long_Data[i/8] & (0x80>>(i%8)))? 1690: 560;
+  }
+  Buf[Len++]=560;
+  IRLibSim_Reset();
+  My_Sender.IRsendRaw::send(Buf,Len,38);
+  TraceLen=IRLibSim_GetTrace(Trace,IRLIB_SIM_EDGES);
+  printf("Sent a %d bit frame: %u intervals with RAWBUF %d\n",LONG_BITS,TraceLen,RAWBUF);
+  bool Got=false;
+  {
+    IRLibSim_Reset();
+    IRrecv My_Receiver(RECV_PIN);
+    My_Receiver.enableIRIn();
+    unsigned long End=IRLibSim_Play(RECV_PIN,IRLibSim_Now()+10000,Trace,TraceLen);
+    while(!Got && IRLibSim_Now()<End+20000) {IRLibSim_Run(1000); Got=My_Receiver.GetResults(&Long_Decoder);}
+    ReportLong("IRrecv",Got);
+  }
+  {
+    IRLibSim_Reset();
+    IRrecvPCI My_Receiver(PCI_INTR);
+    My_Receiver.enableIRIn();
+    unsigned long End=IRLibSim_Play(My_Receiver.getPinNum(),IRLibSim_Now()+10000,Trace,TraceLen);
+    Got=false;
+    while(!Got && IRLibSim_Now()<End+20000) {IRLibSim_Run(1000); Got=My_Receiver.GetResults(&Long_Decoder);}
+    ReportLong("IRrecvPCI",Got);
+  }
+}
+
+/* NEC starts 5ms after the end of a Sony frame. With IRLIB_PREDICT_END IRrecvPCI hands
+ * Sony over 2.4ms into that space, so the first edge of NEC must begin a new frame.
+ * Without it the last Sony frame and NEC run together since the space is under 10ms.
+ */
+void TryCloseFrames(void) {
+  IRLibSim_Reset();
+  My_Sender.send(SONY,0x74bca,20);
+  TraceLen=IRLibSim_GetTrace(Trace,IRLIB_SIM_EDGES);
+  Trace[TraceLen-1]=5000;
+  IRLibSim_Reset();
+  My_Sender.send(NEC,0x61a0f00f,0);
+  TraceLen+=IRLibSim_GetTrace(Trace+TraceLen,IRLIB_SIM_EDGES-TraceLen);
+  printf("Sony and NEC 5ms after it to IRrecvPCI\n");
+  IRLibSim_Reset();
+  IRrecvPCI My_Receiver(PCI_INTR);
+  My_Receiver.enableIRIn();
+  unsigned long End=IRLibSim_Play(My_Receiver.getPinNum(),IRLibSim_Now()+10000,Trace,TraceLen);
+  while(IRLibSim_Now()<End+20000) {
+    IRLibSim_Run(1000);
+    if(My_Receiver.GetResults(&My_Decoder)) {Report("IRrecvPCI",true); My_Receiver.resume();}
+  }
+}
+
+/* Sony sends its frame three times, then comes an NEC code with two repeats 
+ * 40ms after the end of each frame, about what a held button produces.
+ */
+#define BURST_GAP 40000
+void AddToBurst(IRTYPES Type, unsigned long Value, unsigned int Data2) {
+  IRLibSim_Reset();
+  My_Sender.send(Type,Value,Data2);
+  TraceLen+=IRLibSim_GetTrace(Trace+TraceLen,IRLIB_SIM_EDGES-TraceLen);
+  Trace[TraceLen-1]+=BURST_GAP;
+}
+
+template <class Receiver> void TryBurst(const char *Name, Receiver &My_Receiver) {
+  My_Receiver.enableIRIn();
+  unsigned long End=IRLibSim_Play(My_Receiver.getPinNum(),IRLibSim_Now()+10000,Trace,TraceLen);
+  unsigned char Frames=0;
+  printf("  %-10s ",Name);
+  while(IRLibSim_Now()<End+100000) {
+    IRLibSim_Run(100000);
+    while(My_Receiver.GetResults(&My_Decoder)) {
+      My_Decoder.decode();
+      Serial.print(Pnames(My_Decoder.decode_type)); printf(" ");
+      Frames++;
+      My_Receiver.resume();
+    }
+  }
+  printf("(%d received, %d dropped, 6 sent)\n",Frames,My_Receiver.getDroppedFrames());
+}
+
+#define EMIT_BUF 200
+unsigned int Emit_Buf[2][EMIT_BUF];
+unsigned int Gated[2][IRLIB_SIM_EDGES];
+unsigned int GatedLen[2];
+
+void TryMulti(bool Together) {
+  IRLibSim_Reset();
+  IRsendMulti My_Multi;
+  My_Multi.addEmitter(GATE_PIN0,Emit_Buf[0],EMIT_BUF);
+  My_Multi.addEmitter(GATE_PIN1,Emit_Buf[1],EMIT_BUF);
+  if(Together) {
+    My_Multi.load(0,NEC,0x61a0f00f,0);
+    My_Multi.load(1,SONY,0x74bca,20);
+    My_Multi.sendLoaded();
+    printf("NEC and Sony loaded and sent together in %.1fms\n",IRLibSim_Now()/1000.0);
+  } else {
+    My_Multi.send(3,NEC,0x61a0f00f,0);
+    printf("NEC sent on both emitters in %.1fms\n",IRLibSim_Now()/1000.0);
+  }
+  GatedLen[0]=IRLibSim_GetGatedTrace(GATE_PIN0,Gated[0],IRLIB_SIM_EDGES);
+  GatedLen[1]=IRLibSim_GetGatedTrace(GATE_PIN1,Gated[1],IRLIB_SIM_EDGES);
+  for(unsigned char e=0; e<2; e++) {
+    printf("  emitter %d: %u intervals\n",e,GatedLen[e]);
+    memcpy(Trace,Gated[e],GatedLen[e]*sizeof Trace[0]); TraceLen=GatedLen[e];
+    TryIRrecv();
+  }
+}
+
+//Everything but the gap at the end must be the same. That runs until the trace is taken.
+bool SameAsSent(void) {
+  unsigned int Len=IRLibSim_GetTrace(Gated[0],IRLIB_SIM_EDGES);
+  if(Len!=TraceLen) return false;
+  for(unsigned int i=0; i+1<Len; i++) if(Gated[0][i]!=Trace[i]) return false;
+  return true;
+}
+
+void TryPacked(void) {
+  unsigned char Code[256];
+  unsigned char Same=0; unsigned int Bytes=0, Raw=0;
+  for(unsigned char i=0; i<CODES; i++) {
+    IRLibSim_Reset();
+    My_Sender.send(Codes[i].Type,Codes[i].Value,Codes[i].Data2);
+    TraceLen=IRLibSim_GetTrace(Trace,IRLIB_SIM_EDGES);
+    unsigned int Len=IRsendRaw::pack(Trace,TraceLen,IRLibSim_CarrierKHz(),Code,sizeof Code);
+    Bytes+=Len; Raw+=TraceLen*2; //an unsigned int is two bytes on an AVR
+    IRLibSim_Reset();
+    My_Sender.IRsendRaw::send_P(Code);
+    if(Len && SameAsSent()) Same++;
+  }
+  printf("IRsendRaw::send_P sent %d of %d packed codes as IRsend did in %u bytes instead of %u\n",
+    Same,(int)CODES,Bytes,Raw);
+}
+
+/* Pronto counts carrier cycles so each interval may move by up to half a cycle. The code
+ * packed from the Pronto string must give exactly what sendPronto sent.
+ */
+void TryPronto(void) {
+  unsigned int Buf[IRLIB_SIM_EDGES+1];
+  char Pronto[5*(IRLIB_SIM_EDGES+6)];
+  unsigned char Code[256];
+  unsigned char Close=0, Same=0;
+  for(unsigned char i=0; i<CODES; i++) {
+    IRLibSim_Reset();
+    My_Sender.send(Codes[i].Type,Codes[i].Value,Codes[i].Data2);
+    TraceLen=IRLibSim_GetTrace(Trace,IRLIB_SIM_EDGES);
+    unsigned char kHz=IRLibSim_CarrierKHz();
+    Buf[0]=20000; memcpy(Buf+1,Trace,TraceLen*sizeof Trace[0]);
+    IRdecode Capture;
+    Capture.UseExtnBuf(Buf); Capture.rawlen=TraceLen+1;
+    if(!Capture.toPronto(Pronto,sizeof Pronto,kHz)) continue;
+    if(i==0) printf("Pronto for %s: %.49s...\n",(const char *)Pnames(Codes[i].Type),Pronto);
+    IRLibSim_Reset();
+    My_Sender.IRsendRaw::sendPronto(Pronto);
+    unsigned int Len=IRLibSim_GetTrace(Gated[0],IRLIB_SIM_EDGES);
+    bool Near=(Len==TraceLen);
+    for(unsigned int j=0; Near && j+1<Len; j++)
+      Near=abs((int)Gated[0][j]-(int)Trace[j]) <= 500/kHz;
+    if(Near) Close++;
+    IRpronto Parsed;
+    if(Parsed.begin(Pronto) && Parsed.pack(Code,sizeof Code)) {
+      memcpy(Trace,Gated[0],Len*sizeof Trace[0]); TraceLen=Len;
+      IRLibSim_Reset();
+      My_Sender.IRsendRaw::send_P(Code);
+      if(SameAsSent()) Same++;
+    }
+  }
+  printf("IRsendRaw::sendPronto sent %d of %d codes within half a cycle, %d packed from Pronto the same\n",
+    Close,(int)CODES,Same);
+}
+
+/* A learned code of 144 pairs, more than a byte can count. Neither sendPronto nor the
+ * packed code depend on RAWBUF so all 288 intervals must be sent.
+ */
+#define LONG_PAIRS 144
+void TryLongPronto(void) {
+  static char Pronto[5*(2*LONG_PAIRS+4)];
+  char *P=Pronto;
+  P+=sprintf(P,"0000 006D %04X 0000",LONG_PAIRS);
+  for(unsigned int i=0; i<LONG_PAIRS; i++) P+=sprintf(P," 0016 %04X",(i%3)? 0x0016: 0x0041);
+  IRpronto Parsed;
+  bool Began=Parsed.begin(Pronto);
+  printf("Pronto of %d pairs: begin %s, %u intervals",LONG_PAIRS,Began? "true": "false",Parsed.Len);
+  IRLibSim_Reset();
+  My_Sender.IRsendRaw::sendPronto(Pronto);
+  TraceLen=IRLibSim_GetTrace(Trace,IRLIB_SIM_EDGES);
+  printf(", %u sent",TraceLen);
+  static unsigned char Code[1024];
+  if(Began && Parsed.pack(Code,sizeof Code)) {
+    IRLibSim_Reset();
+    My_Sender.IRsendRaw::send_P(Code);
+    printf(", packed %s\n",SameAsSent()? "the same": "NOT the same");
+  }
+  else printf(", not packed\n");
+}
+
+void TryAnalyzer(void) {
+  static IRdecode Captures[4];
+  static unsigned int Bufs[4][RAWBUF];
+  unsigned long Flip[4]={0,0xffffffff,0x5a5a5a5a,0x0ff00ff0};
+  for(unsigned char i=0; i<CODES; i++) {
+    IRanalyzer My_Analyzer;
+    unsigned char Got=0, kHz=0;
+    for(unsigned char j=0; j<4; j++) {
+      unsigned long Value=Codes[i].Value^Flip[j];
+      if(Codes[i].Type==SONY) Value&=0xfffff;
+      else if(Codes[i].Type==RC5) Value&=0x1fff;
+      else if(Codes[i].Type==RC6) Value&=0xfffff;
+      else if(Codes[i].Type==PANASONIC_OLD) Value&=0x3fffff;
+      else if(Codes[i].Type==JVC) Value&=0xffff;
+      IRLibSim_Reset();
+      My_Sender.send(Codes[i].Type,Value,Codes[i].Data2);
+      TraceLen=IRLibSim_GetTrace(Trace,IRLIB_SIM_EDGES);
+      kHz=IRLibSim_CarrierKHz();
+      if(!CaptureIRrecv() || !My_Decoder.decode() || My_Decoder.decode_type!=Codes[i].Type) continue;
+      Captures[Got].UseExtnBuf(Bufs[Got]);
+      Captures[Got].copyBuf(&My_Decoder);
+      Captures[Got].decode();
+      My_Analyzer.add(&Captures[Got++]);
+    }
+    Serial.print(F("IRanalyzer on ")); Serial.print(Pnames(Codes[i].Type)); printf(": ");
+    IRprotocol P;
+    if(!My_Analyzer.analyze(&P,kHz)) {printf("not described\n"); continue;}
+    unsigned char Same=0;
+    for(unsigned char j=0; j<Got; j++) {
+      unsigned long Value=Captures[j].value;
+      if(Captures[j].decodeGeneric(&P) && Captures[j].value==Value) Same++;
+    }
+    printf("{%u, %u, %u, %u, %u, %u, %lu, %u, %u, %s} decodes %d of %d\n",P.Head_Mark,P.Head_Space,
+      P.Mark_One,P.Mark_Zero,P.Space_One,P.Space_Zero,P.Max_Extent,P.kHz,P.Num_Bits,
+      P.Use_Stop? "true": "false",Same,Got);
+  }
+}
+
+#ifdef USE_IRSEND_ASYNC
+unsigned char Async_Done;
+void Async_Count(void) {Async_Done++;}
+
+void TryAsync(void) {
+  IRLibSim_Reset();
+  IRsendAsync My_Async;
+  My_Async.onDone(Async_Count);
+  Async_Done=0;
+  bool Queued=My_Async.send(SONY,0x74bca,20);
+  Queued=My_Async.send(NEC,0x61a0f00f,0) && Queued;
+  printf("IRsendAsync %s Sony and NEC after %luus",Queued? "queued": "failed to queue",IRLibSim_Now());
+  unsigned long Loops=0;
+  while(My_Async.isBusy()) {IRLibSim_Run(100); Loops++;}
+  printf(", sent %d in %.1fms while looping %lu times\n",Async_Done,IRLibSim_Now()/1000.0,Loops);
+  TraceLen=IRLibSim_GetTrace(Trace,IRLIB_SIM_EDGES);
+  IRLibSim_Reset();
+  IRrecv My_Receiver(RECV_PIN);
+  My_Receiver.enableIRIn();
+  unsigned long End=IRLibSim_Play(RECV_PIN,IRLibSim_Now()+10000,Trace,TraceLen);
+  while(IRLibSim_Now()<End+20000) {
+    IRLibSim_Run(1000);
+    if(My_Receiver.GetResults(&My_Decoder)) {Report("IRrecv",true); My_Receiver.resume();}
+  }
+}
+#endif
+
+/* A second receiver needs its own state. Pin 12 and interrupt 1 (pin 3) are its inputs.
+ * GetResults decodes into My_Decoder so each result is reported before the next poll.
+ */
+#define SECOND_PIN 12
+#define SECOND_INTR 1
+volatile irparams_t Second_State;
+unsigned int Second_Trace[IRLIB_SIM_EDGES];
+unsigned int Second_Len;
+
+template <class Receiver> void PollTwo(Receiver &First, Receiver &Second, unsigned long End) {
+  bool Got[2]={false,false};
+  while(!(Got[0] && Got[1]) && IRLibSim_Now()<End+20000) {
+    IRLibSim_Run(1000);
+    if(!Got[0] && First.GetResults(&My_Decoder)) {Got[0]=true; Report("first",true);}
+    if(!Got[1] && Second.GetResults(&My_Decoder)) {Got[1]=true; Report("second",true);}
+  }
+  if(!Got[0]) Report("first",false);
+  if(!Got[1]) Report("second",false);
+}
+
+void TryTwo(bool PCI) {
+  IRLibSim_Reset();
+  My_Sender.send(NEC,0x61a0f00f,0);
+  TraceLen=IRLibSim_GetTrace(Trace,IRLIB_SIM_EDGES);
+  IRLibSim_Reset();
+  My_Sender.send(SONY,0x74bca,20);
+  Second_Len=IRLibSim_GetTrace(Second_Trace,IRLIB_SIM_EDGES);
+  printf("NEC and Sony at once to two %s with IRLIB_MAX_RECEIVERS %d\n",PCI? "IRrecvPCI": "IRrecv",IRLIB_MAX_RECEIVERS);
+  IRLibSim_Reset();
+  bool Enabled;
+  unsigned long End;
+  if(PCI) {
+    IRrecvPCI First(PCI_INTR), Second(SECOND_INTR,&Second_State);
+    First.enableIRIn(); Enabled=Second.enableIRIn();
+    End=IRLibSim_Play(First.getPinNum(),IRLibSim_Now()+10000,Trace,TraceLen);
+    End=max(End,IRLibSim_Play(Second.getPinNum(),IRLibSim_Now()+10000,Second_Trace,Second_Len));
+    if(!Enabled) printf("  second enableIRIn returned false\n");
+    PollTwo(First,Second,End);
+  } else {
+    IRrecv First(RECV_PIN), Second(SECOND_PIN,&Second_State);
+    First.enableIRIn(); Enabled=Second.enableIRIn();
+    End=IRLibSim_Play(RECV_PIN,IRLibSim_Now()+10000,Trace,TraceLen);
+    End=max(End,IRLibSim_Play(SECOND_PIN,IRLibSim_Now()+10000,Second_Trace,Second_Len));
+    if(!Enabled) printf("  second enableIRIn returned false\n");
+    PollTwo(First,Second,End);
+  }
+}
+
+int main(void) {
+  for(unsigned char i=0; i<CODES; i++) {
+    IRLibSim_Reset();
+    My_Sender.send(Codes[i].Type,Codes[i].Value,Codes[i].Data2);
+    TraceLen=IRLibSim_GetTrace(Trace,IRLIB_SIM_EDGES);
+    Serial.print(F("Sent ")); Serial.print(Pnames(Codes[i].Type));
+    printf(" 0x%lx at %d kHz: %u intervals\n",Codes[i].Value,IRLibSim_CarrierKHz(),TraceLen);
+    TryIRrecv();
+    TryIRrecvPCI();
+    TryIRrecvLoop();
+    TryIRrecvHybrid();
+    {IRLibSim_Reset(); IRrecv My_Receiver(RECV_PIN); TryEarly("IRrecv",My_Receiver,true);}
+    {IRLibSim_Reset(); IRrecv My_Receiver(RECV_PIN); TryEarly("IRrecv",My_Receiver,false);}
+    {IRLibSim_Reset(); IRrecvPCI My_Receiver(PCI_INTR); TryEarly("IRrecvPCI",My_Receiver,true);}
+    {IRLibSim_Reset(); IRrecvPCI My_Receiver(PCI_INTR); TryEarly("IRrecvPCI",My_Receiver,false);}
+  }
+  TrySamsung36();
+  TryLoopUnenabled();
+  TryPayload();
+  TryCloseFrames();
+  TraceLen=0;
+  AddToBurst(SONY,0x74bca,20);
+  AddToBurst(NEC,0x61a0f00f,0);
+  AddToBurst(NEC,REPEAT,0);
+  AddToBurst(NEC,REPEAT,0);
+  printf("Burst polled every 100ms with %d capture slots\n",IRLIB_CAPTURE_SLOTS);
+  {IRLibSim_Reset(); IRrecv My_Receiver(RECV_PIN); TryBurst("IRrecv",My_Receiver);}
+  {IRLibSim_Reset(); IRrecvPCI My_Receiver(PCI_INTR); TryBurst("IRrecvPCI",My_Receiver);}
+  TryMulti(false);
+  TryMulti(true);
+  TryPacked();
+  TryPronto();
+  TryLongPronto();
+  TryAnalyzer();
+#ifdef USE_IRSEND_ASYNC
+  TryAsync();
+#endif
+  TryTwo(false);
+  TryTwo(true);
+  return 0;
+}
@@ -0,0 +1,49 @@
+/* IRpronto.cpp from the IRLib host build - a simulated Arduino HAL
+ * Copyright 2014 by Chris Young http://cyborg5.com
+ *
+ * Converts learned Pronto codes to the packed form that IRsendRaw::send_P plays from
+ * flash. Reads one code per line from standard input and writes a PROGMEM array for
+ * each, named Code0, Code1 and so on, ready to paste into a sketch. Lines which are not
+ * a learned Pronto code become a comment, including predefined codes such as 5000 for
+ * RC5, which hold a device and command for IRsend rather than times. The number of codes and how long converting
+ * them took are written to standard error. The same IRpronto class is used as on the
+ * Arduino so what is written is exactly what the sketch would have made itself.
+ *	IRpronto <codes.txt >codes.h
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <IRLib.h>
+
+#define MAX_LINE 8192
+#define MAX_CODE 1024
+
+int main(void) {
+  static char Line[MAX_LINE];
+  unsigned char Code[MAX_CODE];
+  unsigned long Lines=0, Done=0;
+  double Elapsed=0;
+  while(fgets(Line,sizeof Line,stdin)) {
+    Line[strcspn(Line,"\r\n")]=0;
+    if(!Line[0]) continue;
+    std::chrono::steady_clock::time_point Start=std::chrono::steady_clock::now();
+    IRpronto Pronto;
+    unsigned int Len=Pronto.begin(Line)? Pronto.pack(Code,sizeof Code): 0;
+    Elapsed+=std::chrono::duration<double>(std::chrono::steady_clock::now()-Start).count();
+    if(Len) {
+      printf("const unsigned char Code%lu[] PROGMEM={",Done++);
+      for(unsigned int i=0; i<Len; i++) printf(i? ",%u": "%u",Code[i]);
+      printf("};\n");
+    } else if(strtoul(Line,NULL,16)) {
+      printf("//line %lu is a predefined Pronto code, send it with IRsend\n",Lines+1);
+    } else {
+      printf("//line %lu is not a learned Pronto code\n",Lines+1);
+    }
+    Lines++;
+  }
+  fprintf(stderr,"Converted %lu of %lu codes in %.1fms",Done,Lines,Elapsed*1000);
+  if(Elapsed>0) fprintf(stderr,", %.0f per second",Lines/Elapsed);
+  fprintf(stderr,"\n");
+  return 0;
+}
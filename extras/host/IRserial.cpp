@@ -0,0 +1,195 @@
+/* IRserial.cpp from the IRLib host build - a simulated Arduino HAL
+ * Copyright 2014 by Chris Young http://cyborg5.com
+ *
+ * Runs the IRserial_remote example against simulated serial input at 115200 baud and
+ * prints each reply with the time it was written. First a typed code, then binary
+ * frames: several codes with a gap between them, a frame ending in a gap followed at
+ * once by another, raw intervals, a damaged frame made of digits, a bad command and
+ * frames queued while one is being sent. What was transmitted is compared with what
+ * IRsend and IRsendRaw send by themselves.
+ */
+#include <stdio.h>
+#include "IRLibSim.h"
+#include <IRLib.h>
+#include "../../examples/IRserial_remote/IRserial_remote.ino"
+
+IRsend Reference;
+unsigned int Trace[IRLIB_SIM_EDGES], Sent[IRLIB_SIM_EDGES];
+unsigned int TraceLen, SentLen;
+
+/* The host's side of the protocol */
+unsigned char Payload[255], Out[260];
+unsigned char Payload_Len;
+
+void Begin(unsigned char Seq) {Payload[0]=Seq; Payload_Len=1;}
+void Put(unsigned long Value, unsigned char Bytes) {
+  while(Bytes--) {Payload[Payload_Len++]=Value; Value>>=8;}
+}
+void Code(IRTYPES Type, unsigned long Value, unsigned char Bits) {Put('C',1); Put(Type,1); Put(Value,4); Put(Bits,1);}
+void Gap_Of(unsigned int ms) {Put('G',1); Put(ms,2);}
+void Raw_Of(const unsigned int *Buf, unsigned char Count, unsigned char kHz) {
+  Put('R',1); Put(kHz,1); Put(Count,1);
+  for(unsigned char i=0; i<Count; i++) Put(Buf[i],2);
+}
+//Feeds the frame and returns its length. Damage flips a bit of the second check byte.
+unsigned int Feed(bool Damage=false) {
+  unsigned char S1=0, S2=0; unsigned int Len=0;
+  Out[Len++]=FRAME_SYNC; Out[Len++]=Payload_Len; Add(S1,S2,Payload_Len);
+  for(unsigned char i=0; i<Payload_Len; i++) {Out[Len++]=Payload[i]; Add(S1,S2,Payload[i]);}
+  Out[Len++]=S1; Out[Len++]=S2^(Damage? 1: 0);
+  IRLibSim_SerialFeed(Out,Len);
+  return Len;
+}
+
+/* Replies are printed with the time they were written. Text is printed a line at a time. */
+unsigned char Reply_Buf[IRLIB_SIM_SERIAL_QUEUE];
+unsigned long Reply_When[IRLIB_SIM_SERIAL_QUEUE];
+unsigned int Reply_Len;
+unsigned long Last_Done, Last_Usec, Last_Accepted; //time of the last 'D', what it took and time of the last 'A'
+unsigned char Dones, Errors;
+
+void Show(const unsigned char *P, unsigned char Len, unsigned long When) {
+  double T=When/1000.0;
+  if(Len>=2 && P[1]=='A') {printf("  %8.1fms frame %d accepted\n",T,P[0]); Last_Accepted=When;}
+  else if(Len>=7 && P[1]=='D') {
+    Last_Usec=(unsigned long)P[3]|(unsigned long)P[4]<<8|(unsigned long)P[5]<<16|(unsigned long)P[6]<<24;
+    printf("  %8.1fms frame %d command %d done in %luus\n",T,P[0],P[2],Last_Usec);
+    Last_Done=When; Dones++;
+  }
+  else if(Len>=4 && P[1]=='E') {printf("  %8.1fms frame %d error %d at command %d\n",T,P[0],P[2],P[3]); Errors++;}
+  else printf("  %8.1fms unknown reply\n",T);
+}
+
+void Replies(void) {
+  Reply_Len+=IRLibSim_GetSerial(Reply_Buf+Reply_Len,sizeof Reply_Buf-Reply_Len,Reply_When+Reply_Len);
+  unsigned int Used=0;
+  while(Used<Reply_Len) {
+    unsigned char *P=Reply_Buf+Used; unsigned int Left=Reply_Len-Used;
+    if(P[0]!=FRAME_SYNC) {
+      unsigned char *End=(unsigned char *)memchr(P,'\n',Left);
+      if(!End) break;
+      printf("  %8.1fms text %.*s\n",Reply_When[Used]/1000.0,(int)(End-P-1),P);
+      Used+=End-P+1; continue;
+    }
+    if(Left<2 || Left<P[1]+4u) break;
+    unsigned char S1=0, S2=0;
+    for(unsigned char i=0; i<=P[1]; i++) Add(S1,S2,P[1+i]);
+    if(S1!=P[P[1]+2] || S2!=P[P[1]+3]) printf("  bad reply\n");
+    else Show(P+2,P[1],Reply_When[Used]);
+    Used+=P[1]+4;
+  }
+  Reply_Len-=Used;
+  memmove(Reply_Buf,Reply_Buf+Used,Reply_Len);
+  memmove(Reply_When,Reply_When+Used,Reply_Len*sizeof Reply_When[0]);
+}
+
+//Calls loop as the Arduino would, with 100us of other work in between
+void Run_For(unsigned long ms) {
+  unsigned long End=IRLibSim_Now()+ms*1000;
+  while(IRLibSim_Now()<End) {loop(); Replies(); IRLibSim_Run(100);}
+}
+//Until Count commands are done or there is an error
+void Run_Until_Done(unsigned char Count) {
+  Dones=0; Errors=0;
+  while(Dones<Count && !Errors) {loop(); Replies(); IRLibSim_Run(100);}
+}
+
+//Keeps what the sketch transmitted so that IRsend can be run for comparison
+void Taken(void) {
+  TraceLen=IRLibSim_GetTrace(Trace,IRLIB_SIM_EDGES);
+  IRLibSim_ClearTrace(); SentLen=0;
+}
+//Adds what IRsend sends by itself without the gap at the end, which may be anything
+void Expect(IRTYPES Type, unsigned long Value, unsigned char Bits, unsigned char Times=1) {
+  static unsigned int Ref[IRLIB_SIM_EDGES];
+  Reference.send(Type,Value,Bits);
+  unsigned int Len=IRLibSim_GetTrace(Ref,IRLIB_SIM_EDGES)-1;
+  IRLibSim_ClearTrace();
+  for(unsigned char i=0; i<Times; i++) {memcpy(Sent+SentLen,Ref,Len*sizeof Ref[0]); SentLen+=Len; Sent[SentLen++]=0;}
+}
+void Compare(const char *What) {
+  bool Same= TraceLen==SentLen;
+  for(unsigned int i=0; Same && i<TraceLen; i++) if(Sent[i] && Trace[i]!=Sent[i]) Same=false;
+  printf("  %s: %u intervals sent, %s\n",What,TraceLen,Same? "the same as IRsend": "NOT the same as IRsend");
+}
+
+unsigned int Code_Frame(unsigned char Seq, unsigned char Codes) {
+  Begin(Seq);
+  for(unsigned char i=0; i<Codes; i++) Code(NEC,0x61a0f00f,0);
+  return Feed();
+}
+
+int main(void) {
+  IRLibSim_Reset();
+  IRLibSim_CaptureSerial(true);
+  setup();
+
+  printf("A typed code\n");
+  const char *Typed="5,37c107\n";
+  IRLibSim_SerialFeed((const unsigned char *)Typed,strlen(Typed));
+  Run_For(1000);
+  Taken(); Expect(PANASONIC_OLD,0x37c107,0); Compare("Panasonic_Old");
+
+  printf("One frame of NEC, Sony, a 50ms gap and NEC\n");
+  Begin(1); Code(NEC,0x61a0f00f,0); Code(SONY,0x74bca,20); Gap_Of(50); Code(NEC,0x61a0f00f,0);
+  printf("  %u bytes\n",Feed());
+  Run_Until_Done(3);
+  unsigned long Gap_From=Last_Done;
+  Run_Until_Done(1);
+  printf("  the last code began %.1fms after the gap\n",(Last_Done-Last_Usec-Gap_From)/1000.0);
+  Taken(); Expect(NEC,0x61a0f00f,0); Expect(SONY,0x74bca,20); Expect(NEC,0x61a0f00f,0); Compare("NEC, Sony, NEC");
+
+  printf("A frame ending in a 100ms gap and another sent at once\n");
+  Begin(2); Code(NEC,0x61a0f00f,0); Gap_Of(100); Feed();
+  Begin(3); Code(SONY,0x74bca,20); Feed();
+  Run_Until_Done(2);
+  Gap_From=Last_Done;
+  Run_Until_Done(1);
+  printf("  frame 3 was accepted %.1fms after the gap\n",(Last_Accepted-Gap_From)/1000.0);
+  Taken(); Expect(NEC,0x61a0f00f,0); Expect(SONY,0x74bca,20); Compare("NEC, Sony");
+
+  printf("Raw intervals of NEC at 38kHz\n");
+  Reference.send(NEC,0x61a0f00f,0);
+  unsigned int Len=IRLibSim_GetTrace(Trace,IRLIB_SIM_EDGES)-1;
+  IRLibSim_ClearTrace();
+  Begin(4); Raw_Of(Trace,Len,38);
+  printf("  %u bytes\n",Feed());
+  Run_Until_Done(1);
+  Taken(); Expect(NEC,0x61a0f00f,0); Compare("Raw");
+
+  printf("A damaged frame whose payload is a typed code\n");
+  Begin(5); for(const char *C=Typed; *C; C++) Put(*C,1);
+  Feed(true);
+  Run_For(1000);
+  Taken(); Compare("Nothing");
+
+  printf("A bad command between two good ones\n");
+  Begin(6); Code(NEC,0x61a0f00f,0); Put('Z',1); Code(NEC,0x61a0f00f,0); Feed();
+  Run_Until_Done(2);
+  Taken(); Expect(NEC,0x61a0f00f,0); Compare("NEC");
+
+  printf("Frames of eight codes queued one ahead of the last accepted\n");
+  unsigned char Seq=7, Fed=1, Accepted=0;
+  printf("  %u bytes each\n",Code_Frame(Seq,8));
+  Dones=0;
+  while(Dones<32) {
+    unsigned long Was=Last_Accepted;
+    loop(); Replies();
+    if(Last_Accepted!=Was) Accepted++;
+    if(Fed<4 && Accepted==Fed) {Code_Frame(++Seq,8); Fed++;}
+    IRLibSim_Run(100);
+  }
+  printf("  %lu bytes lost\n",IRLibSim_SerialLost());
+  Taken(); Expect(NEC,0x61a0f00f,0,32); Compare("32 NEC");
+
+  printf("A longer frame sent right behind one, which breaks the rule\n");
+  Begin(20); Code(SONY,0x74bca,20); Feed();
+  printf("  %u bytes\n",Code_Frame(21,14));
+  Run_Until_Done(2);
+  printf("  %lu bytes lost\n",IRLibSim_SerialLost());
+  printf("The same frame sent again once the transmitter is idle\n");
+  Code_Frame(21,14);
+  Run_Until_Done(14);
+  Taken(); Expect(SONY,0x74bca,20); Expect(NEC,0x61a0f00f,0,14); Compare("Sony and 14 NEC");
+  return 0;
+}
@@ -0,0 +1,14 @@
+/* avr/interrupt.h for the IRLib host build - a simulated Arduino HAL
+ * Copyright 2014 by Chris Young http://cyborg5.com
+ *
+ * An ISR becomes an ordinary C function named after its vector. The simulator
+ * calls it whenever the corresponding simulated timer interrupt is due.
+ */
+#ifndef IRLibSim_interrupt_h
+#define IRLibSim_interrupt_h
+
+#define ISR(vector, ...) extern "C" void vector(void)
+void cli(void);
+void sei(void);
+
+#endif //IRLibSim_interrupt_h
@@ -0,0 +1,21 @@
+/* avr/pgmspace.h for the IRLib host build - a simulated Arduino HAL
+ * Copyright 2014 by Chris Young http://cyborg5.com
+ *
+ * There is only one address space on the host so flash reads are plain reads.
+ */
+#ifndef IRLibSim_pgmspace_h
+#define IRLibSim_pgmspace_h
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define pgm_read_ptr(addr) (*(void * const *)(addr))
+#define memcpy_P memcpy
+#define strlen_P strlen
+
+#endif //IRLibSim_pgmspace_h